@@ -27,6 +27,13 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 #include <typeindex>                    // std::type_index
 #include <typeinfo>
 #include <unordered_map>
+#include <algorithm>                    // std::max
+#include <chrono>                       // std::chrono::system_clock
+#include <functional>                   // std::bind
+#include <set>                          // std::set
+
+#include "simple_voip/object_factory.h" // simple_voip::create_initiate_call_request
+#include "scheduler/onetime_job_aux.h"  // scheduler::create_and_insert_one_time_job
 
 #include "utils/mutex_helper.h"         // MUTEX_SCOPE_LOCK
 #include "utils/dummy_logger.h"         // dummy_log
@@ -38,15 +45,55 @@ NAMESPACE_CALMAN_START
 
 CallManager::CallManager():
     log_id_( 0 ),
-    voips_( nullptr ), callback_( nullptr )
+    next_queue_seq_( 0 ),
+    head_queue_seq_( 0 ),
+    mean_slot_time_( 0 ),
+    num_slot_samples_( 0 ),
+    queue_callback_( nullptr ),
+    is_draining_( false ),
+    dial_list_( nullptr ),
+    voips_( nullptr ), callback_( nullptr ),
+    is_delivering_( false ),
+    sched_( nullptr ),
+    clock_( nullptr ),
+    retry_guard_( std::make_shared<RetryGuard>() ),
+    rng_( std::random_device()() ),
+    num_retries_( 0 ),
+    num_retries_exhausted_( 0 ),
+    total_retry_delay_( 0 ),
+    num_dispatched_( 0 ),
+    num_established_( 0 ),
+    num_failed_( 0 )
 {
+    retry_guard_->is_alive  = true;
 }
 
 CallManager::~CallManager()
 {
-    MUTEX_SCOPE_LOCK( mutex_ );
+    {
+        // waits for a retry job being executed, the ones executed later do nothing
+        MUTEX_SCOPE_LOCK( retry_guard_->mutex );
 
-    request_queue_.clear();
+        retry_guard_->is_alive  = false;
+    }
+
+    JobIds job_ids;
+
+    {
+        MUTEX_SCOPE_LOCK( mutex_ );
+
+        for( auto & e : map_req_id_to_retry_job_id_ )
+            job_ids.push_back( e.second );
+
+        map_req_id_to_retry_job_id_.clear();
+
+        if( request_queue_.empty() == false )
+            dummy_log_warn( log_id_, "discarding %u pending requests", request_queue_.size() );
+
+        clear_pending();
+    }
+
+    delete_retry_jobs( job_ids );
 }
 
 bool CallManager::init(
@@ -55,6 +102,17 @@ bool CallManager::init(
         simple_voip::ISimpleVoipCallback    * callback,
         const Config                        & cfg,
         std::string                         * error_msg )
+{
+    return init( log_id, voips, callback, nullptr, cfg, error_msg );
+}
+
+bool CallManager::init(
+        unsigned int                        log_id,
+        simple_voip::ISimpleVoip            * voips,
+        simple_voip::ISimpleVoipCallback    * callback,
+        scheduler::IScheduler               * sched,
+        const Config                        & cfg,
+        std::string                         * error_msg )
 {
     if( voips == nullptr )
         return false;
@@ -73,6 +131,8 @@ bool CallManager::init(
     log_id_     = log_id;
     voips_      = voips;
     callback_   = callback;
+    sched_      = sched;
+    clock_      = dynamic_cast<IClock*>( sched );
     cfg_        = cfg;
 
     if( cfg_.max_active_calls < 1 )
@@ -81,15 +141,326 @@ bool CallManager::init(
         return false;
     }
 
-    dummy_log_debug( log_id_, "inited, max_active_calls=%u", cfg_.max_active_calls );
+    if( cfg_.max_attempts < 1 )
+    {
+        * error_msg = "max_attempts < 1";
+        return false;
+    }
+
+    if( cfg_.max_attempts > 1 && sched_ == nullptr )
+    {
+        * error_msg = "scheduler is required for retries";
+        return false;
+    }
+
+    if( cfg_.retry_delay_min > cfg_.retry_delay_max )
+    {
+        * error_msg = "retry_delay_min > retry_delay_max";
+        return false;
+    }
+
+    if( cfg_.stats_shm_name.empty() == false )
+    {
+        if( stats_publisher_.init( cfg_.stats_shm_name, error_msg ) == false )
+            return false;
+    }
+
+    dummy_log_debug( log_id_, "inited, max_active_calls=%u, max_attempts=%u", cfg_.max_active_calls, cfg_.max_attempts );
+
+    log_stat();
 
     return true;
 }
 
-void CallManager::consume( const simple_voip::ForwardObject* obj )
+bool CallManager::set_dial_list( IDialList * dial_list, std::string * error_msg )
+{
+    MUTEX_SCOPE_LOCK( mutex_ );
+
+    if( voips_ == nullptr )
+    {
+        * error_msg = "not inited";
+        return false;
+    }
+
+    if( dial_list != nullptr && dial_list_ != nullptr )
+    {
+        * error_msg = "dial list is already set";
+        return false;
+    }
+
+    if( dial_list != nullptr )
+    {
+        uint32_t first_req_id;
+        uint32_t num_req_ids;
+
+        dial_list->get_req_id_range( & first_req_id, & num_req_ids );
+
+        if( is_req_id_range_in_use( first_req_id, num_req_ids ) )
+        {
+            * error_msg = "req_id range of the dial list overlaps requests in use";
+            return false;
+        }
+    }
+
+    dial_list_  = dial_list;
+
+    dummy_log_debug( log_id_, "dial list %s", dial_list ? "set" : "detached" );
+
+    process_jobs();
+
+    return true;
+}
+
+void CallManager::set_queue_callback( IQueueCallback * queue_callback )
 {
     MUTEX_SCOPE_LOCK( mutex_ );
 
+    queue_callback_ = queue_callback;
+}
+
+bool CallManager::get_queue_position( uint32_t req_id, uint32_t * position, uint32_t * estimated_wait_ms ) const
+{
+    MUTEX_SCOPE_LOCK( mutex_ );
+
+    auto it = map_req_id_to_queue_seq_.find( req_id );
+
+    if( it == map_req_id_to_queue_seq_.end() )
+        return false;
+
+    * position          = it->second - head_queue_seq_;
+    * estimated_wait_ms = get_estimated_wait( * position );
+
+    return true;
+}
+
+bool CallManager::import_pending( const PendingRequests & reqs, std::string * error_msg )
+{
+    MUTEX_SCOPE_LOCK( mutex_ );
+
+    if( voips_ == nullptr )
+    {
+        * error_msg = "not inited";
+        return false;
+    }
+
+    if( is_draining_ )
+    {
+        * error_msg = "draining";
+        return false;
+    }
+
+    // answers to a conflicting request would be taken for answers to another one,
+    // so the backlog is imported as a whole or not at all
+    std::set<uint32_t> req_ids;
+
+    for( auto & r : reqs )
+    {
+        const char * reason = nullptr;
+
+        if( req_ids.insert( r.req_id ).second == false )
+            reason = "is duplicated";
+        else if( is_req_id_range_in_use( r.req_id, 1 ) )
+            reason = "is in use";
+        else if( is_reserved_by_dial_list( r.req_id ) )
+            reason = "is reserved by the dial list";
+
+        if( reason )
+        {
+            * error_msg = "req_id " + std::to_string( r.req_id ) + " " + reason;
+
+            dummy_log_error( log_id_, "cannot import pending requests: %s", error_msg->c_str() );
+
+            return false;
+        }
+    }
+
+    for( auto & r : reqs )
+        push_pending( simple_voip::create_initiate_call_request( r.req_id, r.party ) );
+
+    dummy_log_info( log_id_, "imported %u pending requests", reqs.size() );
+
+    process_jobs();
+
+    return true;
+}
+
+bool CallManager::drain( drain_policy_e policy, uint32_t timeout_ms, PendingRequests * exported )
+{
+    std::unique_lock<std::mutex> lock( mutex_ );
+
+    if( voips_ == nullptr )
+        return false;
+
+    if( policy == drain_policy_e::EXPORT && exported == nullptr )
+    {
+        dummy_log_error( log_id_, "drain: no storage for exported requests" );
+        return false;
+    }
+
+    dummy_log_info( log_id_, "drain: policy %s, timeout %u ms", policy == drain_policy_e::EXPORT ? "EXPORT" : "REJECT", timeout_ms );
+
+    is_draining_    = true;
+    dial_list_      = nullptr;
+
+    JobIds job_ids;
+
+    take_pending_for_drain( policy, exported, & job_ids );
+
+    log_stat();
+
+    deliver( lock );
+
+    lock.unlock();
+
+    delete_retry_jobs( job_ids );
+
+    lock.lock();
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds( timeout_ms );
+
+    while( get_num_of_activities() > 0 )
+    {
+        auto now = std::chrono::steady_clock::now();
+
+        if( now >= deadline )
+        {
+            dummy_log_warn( log_id_, "drain: timeout, %u active calls, %u active requests left",
+                    active_call_ids_.size(), active_request_ids_.size() );
+
+            return false;
+        }
+
+        // wake up at least once a second to report progress
+        cond_.wait_until( lock, std::min( deadline, now + std::chrono::seconds( 1 ) ) );
+
+        dummy_log_info( log_id_, "drain: waiting for %u active calls, %u active requests",
+                active_call_ids_.size(), active_request_ids_.size() );
+    }
+
+    dummy_log_info( log_id_, "drain: done" );
+
+    return true;
+}
+
+void CallManager::take_pending_for_drain( drain_policy_e policy, PendingRequests * exported, JobIds * job_ids )
+{
+    // private: no mutex lock
+
+    // the jobs are deleted by the caller after releasing the lock, a job that fires meanwhile finds nothing to do
+
+    for( auto & e : map_req_id_to_retry_job_id_ )
+    {
+        job_ids->push_back( e.second );
+
+        auto & party = map_req_id_to_retry_info_[ e.first ].party;
+
+        if( policy == drain_policy_e::EXPORT )
+            exported->push_back( PendingRequest{ e.first, party } );
+        else
+            reject_request( e.first, "draining" );
+
+        map_req_id_to_retry_info_.erase( e.first );
+    }
+
+    auto num_retries = map_req_id_to_retry_job_id_.size();
+
+    map_req_id_to_retry_job_id_.clear();
+
+    for( auto req : request_queue_ )
+    {
+        if( policy == drain_policy_e::EXPORT )
+            exported->push_back( PendingRequest{ req->req_id, req->party } );
+        else
+            reject_request( req->req_id, "draining" );
+    }
+
+    dummy_log_info( log_id_, "drain: %s %u pending requests and %u waiting retries",
+            policy == drain_policy_e::EXPORT ? "exported" : "rejected", request_queue_.size(), num_retries );
+
+    clear_pending();
+}
+
+void CallManager::reject_exported( const PendingRequests & exported )
+{
+    std::unique_lock<std::mutex> lock( mutex_ );
+
+    for( auto & r : exported )
+        reject_request( r.req_id, "draining, export failed" );
+
+    deliver( lock );
+}
+
+void CallManager::reject_request( uint32_t req_id, const char * reason )
+{
+    // private: no mutex lock
+
+    num_failed_++;
+
+    defer( simple_voip::create_reject_response( req_id, 0, reason ) );
+}
+
+void CallManager::defer( const simple_voip::CallbackObject * obj )
+{
+    // private: no mutex lock
+
+    deferred_.push_back( DeferredCallback{ obj, QueuedNotice() } );
+}
+
+void CallManager::defer( const QueuedNotice & notice )
+{
+    // private: no mutex lock
+
+    deferred_.push_back( DeferredCallback{ nullptr, notice } );
+}
+
+void CallManager::deliver( std::unique_lock<std::mutex> & lock )
+{
+    // private: called with mutex lock, returns with it
+
+    auto call = [this]( const DeferredCallback & d )
+    {
+        if( d.obj )
+            callback_->consume( d.obj );
+        else
+            d.notice.callback->on_queued( d.notice.req_id, d.notice.position, d.notice.estimated_wait_ms );
+    };
+
+    if( cfg_.unlocked_callbacks == false )
+    {
+        for( auto & d : deferred_ )
+            call( d );
+
+        deferred_.clear();
+
+        return;
+    }
+
+    // the thread delivering now, maybe this one further up the stack, takes these as well,
+    // so that the callbacks keep their order and do not overlap
+    if( is_delivering_ )
+        return;
+
+    is_delivering_  = true;
+
+    while( deferred_.empty() == false )
+    {
+        DeferredCallbacks deferred;
+
+        deferred.swap( deferred_ );
+
+        lock.unlock();
+
+        for( auto & d : deferred )
+            call( d );
+
+        lock.lock();
+    }
+
+    is_delivering_  = false;
+}
+
+void CallManager::consume( const simple_voip::ForwardObject* obj )
+{
     typedef CallManager Type;
 
     typedef void (Type::*PPMF)( const simple_voip::ForwardObject * r );
@@ -104,9 +475,20 @@ void CallManager::consume( const simple_voip::ForwardObject* obj )
 
 #undef HANDLER_MAP_ENTRY
 
+    std::unique_lock<std::mutex> lock( mutex_ );
+
     auto it = funcs.find( typeid( * obj ) );
 
-    if( it != funcs.end() )
+    if( is_reserved_by_dial_list( obj->req_id ) )
+    {
+        // answers to this request would be taken for answers to a dial list entry
+        dummy_log_error( log_id_, "rejected request %u, req_id is reserved by the dial list", obj->req_id );
+
+        reject_request( obj->req_id, "req_id is reserved by the dial list" );
+
+        delete obj;
+    }
+    else if( it != funcs.end() )
     {
         (this->*it->second)( obj );
     }
@@ -114,15 +496,15 @@ void CallManager::consume( const simple_voip::ForwardObject* obj )
     {
         voips_->consume( obj );
     }
+
+    deliver( lock );
 }
 
 void CallManager::consume( const simple_voip::CallbackObject* obj )
 {
-    MUTEX_SCOPE_LOCK( mutex_ );
-
     typedef CallManager Type;
 
-    typedef void (Type::*PPMF)( const simple_voip::CallbackObject * r );
+    typedef bool (Type::*PPMF)( const simple_voip::CallbackObject * r );
 
 #define HANDLER_MAP_ENTRY(_v)       { typeid( simple_voip::_v ),            & Type::handle_##_v }
 
@@ -138,14 +520,26 @@ void CallManager::consume( const simple_voip::CallbackObject* obj )
 
 #undef HANDLER_MAP_ENTRY
 
+    bool should_forward = true;
+
+    std::unique_lock<std::mutex> lock( mutex_ );
+
+    auto pos = deferred_.size();
+
     auto it = funcs.find( typeid( * obj ) );
 
     if( it != funcs.end() )
     {
-        (this->*it->second)( obj );
+        should_forward = (this->*it->second)( obj );
     }
 
-    callback_->consume( obj );
+    // the object goes ahead of the callbacks its handling caused
+    if( should_forward )
+        deferred_.insert( deferred_.begin() + pos, DeferredCallback{ obj, QueuedNotice() } );
+    else
+        delete obj;
+
+    deliver( lock );
 }
 
 void CallManager::process_jobs()
@@ -154,41 +548,162 @@ void CallManager::process_jobs()
 
     log_stat();
 
+    if( is_draining_ )
+    {
+        cond_.notify_all();
+        return;
+    }
+
     while( get_num_of_activities() < cfg_.max_active_calls )
     {
-        if( request_queue_.empty() )
+        const simple_voip::InitiateCallRequest * req;
+
+        if( take_next_job( & req ) == false )
         {
-            dummy_log_debug( log_id_, "process_jobs: request queue is empty" );
+            dummy_log_debug( log_id_, "process_jobs: no more jobs" );
             break;
         }
 
-        auto req = request_queue_.front();
+        process( req );
+    }
+
+    log_stat();
+}
+
+void CallManager::push_pending( const simple_voip::InitiateCallRequest * req )
+{
+    // private: no mutex lock
+
+    map_req_id_to_queue_seq_[ req->req_id ] = next_queue_seq_++;
 
-        dummy_log_debug( log_id_, "process_jobs: taking job id %u from queue", req->req_id );
+    request_queue_.push_back( req );
+}
 
-        request_queue_.pop_front();
+const simple_voip::InitiateCallRequest * CallManager::pop_pending()
+{
+    // private: no mutex lock
 
-        process( req );
+    auto req = request_queue_.front();
+
+    request_queue_.pop_front();
+
+    auto it = map_req_id_to_queue_seq_.find( req->req_id );
+
+    // a duplicate req_id queued later keeps its entry
+    if( it != map_req_id_to_queue_seq_.end() && it->second == head_queue_seq_ )
+        map_req_id_to_queue_seq_.erase( it );
+
+    head_queue_seq_++;
+
+    return req;
+}
+
+void CallManager::clear_pending()
+{
+    // private: no mutex lock
+
+    for( auto req : request_queue_ )
+        delete req;
+
+    request_queue_.clear();
+    map_req_id_to_queue_seq_.clear();
+
+    head_queue_seq_ = next_queue_seq_;
+}
+
+CallManager::Time CallManager::get_now() const
+{
+    return clock_ ? clock_->get_now() : std::chrono::system_clock::now();
+}
+
+void CallManager::on_slot_released( const Time & start )
+{
+    // private: no mutex lock
+
+    static const double MIN_WEIGHT = 0.05;
+
+    // the wall clock may be set back while the slot is taken
+    double sample = std::max( 0.0, std::chrono::duration<double, std::milli>( get_now() - start ).count() );
+
+    num_slot_samples_++;
+
+    // plain average while there are few samples, exponential moving average afterwards
+    double weight = std::max( 1.0 / num_slot_samples_, MIN_WEIGHT );
+
+    mean_slot_time_ += weight * ( sample - mean_slot_time_ );
+}
+
+uint32_t CallManager::get_estimated_wait( uint32_t position ) const
+{
+    // private: no mutex lock
+
+    // a slot is released every mean_slot_time_ / max_active_calls ms on average,
+    // the request at 'position' is dispatched after position + 1 releases
+
+    if( num_slot_samples_ == 0 )
+        return UNKNOWN_WAIT;
+
+    return static_cast<uint32_t>( ( position + 1 ) * mean_slot_time_ / cfg_.max_active_calls );
+}
+
+bool CallManager::take_next_job( const simple_voip::InitiateCallRequest ** req )
+{
+    // private: no mutex lock
+
+    if( request_queue_.empty() == false )
+    {
+        * req = pop_pending();
+
+        dummy_log_debug( log_id_, "process_jobs: taking job id %u from queue", ( * req )->req_id );
+
+        return true;
     }
 
-    log_stat();
+    if( dial_list_ == nullptr )
+        return false;
+
+    uint32_t    req_id;
+    std::string party;
+
+    if( dial_list_->get_next( & req_id, & party ) == false )
+        return false;
+
+    dummy_log_debug( log_id_, "process_jobs: taking job id %u from dial list", req_id );
+
+    * req = simple_voip::create_initiate_call_request( req_id, party );
+
+    return true;
 }
 
 void CallManager::process( const simple_voip::InitiateCallRequest * req )
 {
     // private: no mutex lock
 
-    auto res = active_request_ids_.insert( req->req_id ).second;
+    auto res = active_request_ids_.insert( std::make_pair( req->req_id, get_now() ) ).second;
 
     if( res == false )
     {
-        dummy_log_error( log_id_, "request %u already exists", req->req_id );
+        dummy_log_error( log_id_, "request %u already exists, dropped", req->req_id );
 
         ASSERT( 0 );
 
+        delete req;
+
         return;
     }
 
+    if( cfg_.max_attempts > 1 )
+    {
+        auto & info = map_req_id_to_retry_info_[ req->req_id ];
+
+        if( info.attempt == 0 )
+            info.party  = req->party;
+
+        info.attempt++;
+    }
+
+    num_dispatched_++;
+
     voips_->consume( req );
 }
 
@@ -196,9 +711,40 @@ bool CallManager::shutdown()
 {
     dummy_log_debug( log_id_, "shutdown()" );
 
-    MUTEX_SCOPE_LOCK( mutex_ );
+    {
+        MUTEX_SCOPE_LOCK( mutex_ );
 
-    return true;
+        // cfg_ is not set yet
+        if( voips_ == nullptr )
+        {
+            dummy_log_error( log_id_, "shutdown: not inited" );
+            return false;
+        }
+    }
+
+    PendingRequests exported;
+
+    bool res = drain( cfg_.drain_policy, cfg_.drain_timeout, & exported );
+
+    if( cfg_.drain_policy == drain_policy_e::EXPORT )
+    {
+        std::string error_msg;
+
+        if( save_pending_requests( cfg_.drain_export_file, exported, & error_msg ) == false )
+        {
+            // nobody is going to take the requests over, so the clients get an answer at least
+
+            dummy_log_error( log_id_, "cannot export pending requests: %s, rejecting %u requests", error_msg.c_str(), exported.size() );
+
+            reject_exported( exported );
+
+            return false;
+        }
+
+        dummy_log_info( log_id_, "exported %u pending requests to %s", exported.size(), cfg_.drain_export_file.c_str() );
+    }
+
+    return res;
 }
 
 void CallManager::handle_InitiateCallRequest( const simple_voip::ForwardObject * rreq )
@@ -207,13 +753,41 @@ void CallManager::handle_InitiateCallRequest( const simple_voip::ForwardObject *
 
     // private: no mutex lock
 
+    if( is_draining_ )
+    {
+        dummy_log_debug( log_id_, "draining, rejected job %u", req->req_id );
+
+        reject_request( req->req_id, "draining" );
+
+        delete req;
+
+        return;
+    }
+
     log_stat();
 
     if( get_num_of_activities() >= cfg_.max_active_calls )
     {
-        request_queue_.push_back( req );
+        uint32_t position   = request_queue_.size();
+        auto estimated_wait = get_estimated_wait( position );
+
+        if( cfg_.max_estimated_wait > 0 && estimated_wait != UNKNOWN_WAIT && estimated_wait > cfg_.max_estimated_wait )
+        {
+            dummy_log_debug( log_id_, "insert_job: rejected job %u, estimated wait %u ms", req->req_id, estimated_wait );
+
+            reject_request( req->req_id, "estimated wait is too long" );
 
-        dummy_log_debug( log_id_, "insert_job: inserted job %u", req->req_id );
+            delete req;
+
+            return;
+        }
+
+        push_pending( req );
+
+        dummy_log_debug( log_id_, "insert_job: inserted job %u, position %u, estimated wait %u ms", req->req_id, position, estimated_wait );
+
+        if( queue_callback_ )
+            defer( QueuedNotice{ queue_callback_, req->req_id, position, estimated_wait } );
 
         log_stat();
 
@@ -223,6 +797,39 @@ void CallManager::handle_InitiateCallRequest( const simple_voip::ForwardObject *
     process( req );
 }
 
+template <class MAP>
+bool has_key_in_range( const MAP & map, uint32_t first, uint32_t num )
+{
+    auto it = map.lower_bound( first );
+
+    return it != map.end() && it->first - first < num;
+}
+
+bool CallManager::is_req_id_range_in_use( uint32_t first_req_id, uint32_t num_req_ids ) const
+{
+    // private: no mutex lock
+
+    return has_key_in_range( active_request_ids_, first_req_id, num_req_ids )
+        || has_key_in_range( map_req_id_to_queue_seq_, first_req_id, num_req_ids )
+        || has_key_in_range( map_req_id_to_retry_info_, first_req_id, num_req_ids )
+        || has_key_in_range( map_drop_req_id_to_call_id_, first_req_id, num_req_ids );
+}
+
+bool CallManager::is_reserved_by_dial_list( uint32_t req_id ) const
+{
+    // private: no mutex lock
+
+    if( dial_list_ == nullptr )
+        return false;
+
+    uint32_t first_req_id;
+    uint32_t num_req_ids;
+
+    dial_list_->get_req_id_range( & first_req_id, & num_req_ids );
+
+    return req_id - first_req_id < num_req_ids;
+}
+
 void CallManager::handle_DropRequest( const simple_voip::ForwardObject * rreq )
 {
     auto * req = dynamic_cast< const simple_voip::DropRequest *>( rreq );
@@ -244,7 +851,7 @@ void CallManager::handle_DropRequest( const simple_voip::ForwardObject * rreq )
 }
 
 // ISimpleVoipCallback interface
-void CallManager::handle_InitiateCallResponse( const simple_voip::CallbackObject * oobj )
+bool CallManager::handle_InitiateCallResponse( const simple_voip::CallbackObject * oobj )
 {
     auto * obj = dynamic_cast< const simple_voip::InitiateCallResponse *>( oobj );
 
@@ -255,12 +862,16 @@ void CallManager::handle_InitiateCallResponse( const simple_voip::CallbackObject
     if( it == active_request_ids_.end() )
     {
         dummy_log_error( log_id_, "unknown call id %u", obj->call_id );
-        return;
+        return true;
     }
 
+    auto start = it->second;
+
     active_request_ids_.erase( it );
 
-    auto b = active_call_ids_.insert( obj->call_id ).second;
+    map_req_id_to_retry_info_.erase( obj->req_id );
+
+    auto b = active_call_ids_.insert( std::make_pair( obj->call_id, start ) ).second;
 
     if( b == false )
     {
@@ -268,56 +879,40 @@ void CallManager::handle_InitiateCallResponse( const simple_voip::CallbackObject
 
         ASSERT( 0 );
 
-        return;
+        return true;
     }
 
+    num_established_++;
+
     dummy_log_debug( log_id_, "call id %u - active", obj->call_id );
 
     log_stat();
+
+    return true;
 }
 
-void CallManager::handle_RejectResponse( const simple_voip::CallbackObject * oobj )
+bool CallManager::handle_RejectResponse( const simple_voip::CallbackObject * oobj )
 {
     auto * obj = dynamic_cast< const simple_voip::RejectResponse *>( oobj );
 
-    auto it = active_request_ids_.find( obj->req_id );
-
-    if( it == active_request_ids_.end() )
-    {
-        erase_failed_drop_request( obj->req_id );
-        return;
-    }
-
-    active_request_ids_.erase( it );
-
-    process_jobs();
+    return handle_failed_request( obj->req_id, cfg_.retry_reject_codes.count( obj->errorcode ) > 0 );
 }
 
-void CallManager::handle_ErrorResponse( const simple_voip::CallbackObject * oobj )
+bool CallManager::handle_ErrorResponse( const simple_voip::CallbackObject * oobj )
 {
     auto * obj = dynamic_cast< const simple_voip::ErrorResponse *>( oobj );
 
-    auto it = active_request_ids_.find( obj->req_id );
-
-    if( it == active_request_ids_.end() )
-    {
-        erase_failed_drop_request( obj->req_id );
-        return;
-    }
-
-    active_request_ids_.erase( it );
-
-    process_jobs();
+    return handle_failed_request( obj->req_id, cfg_.retry_error_codes.count( obj->errorcode ) > 0 );
 }
 
-void CallManager::handle_DropResponse( const simple_voip::CallbackObject * oobj )
+bool CallManager::handle_DropResponse( const simple_voip::CallbackObject * oobj )
 {
     auto * obj = dynamic_cast< const simple_voip::DropResponse *>( oobj );
 
     auto it = map_drop_req_id_to_call_id_.find( obj->req_id );
 
     if( it == map_drop_req_id_to_call_id_.end() )
-        return;
+        return true;
 
     auto call_id = it->second;
 
@@ -328,26 +923,161 @@ void CallManager::handle_DropResponse( const simple_voip::CallbackObject * oobj
     if( it_2 == active_call_ids_.end() )
     {
         dummy_log_warn( log_id_, "unknown call id %u", call_id );
-        return;
+        return true;
     }
 
+    on_slot_released( it_2->second );
+
     active_call_ids_.erase( it_2 );
 
     process_jobs();
+
+    return true;
 }
 
-void CallManager::handle_ConnectionLost( const simple_voip::CallbackObject * oobj )
+bool CallManager::handle_ConnectionLost( const simple_voip::CallbackObject * oobj )
 {
     auto * obj = dynamic_cast< const simple_voip::ConnectionLost *>( oobj );
 
     handle_failed_call( obj->call_id );
+
+    return true;
 }
 
-void CallManager::handle_Failed( const simple_voip::CallbackObject * oobj )
+bool CallManager::handle_Failed( const simple_voip::CallbackObject * oobj )
 {
     auto * obj = dynamic_cast< const simple_voip::Failed *>( oobj );
 
     handle_failed_call( obj->call_id );
+
+    return true;
+}
+
+bool CallManager::handle_failed_request( uint32_t req_id, bool is_retryable )
+{
+    auto it = active_request_ids_.find( req_id );
+
+    if( it == active_request_ids_.end() )
+    {
+        erase_failed_drop_request( req_id );
+        return true;
+    }
+
+    on_slot_released( it->second );
+
+    active_request_ids_.erase( it );
+
+    bool should_forward = true;
+
+    auto it_2 = map_req_id_to_retry_info_.find( req_id );
+
+    if( it_2 != map_req_id_to_retry_info_.end() )
+    {
+        if( is_retryable && is_draining_ == false && it_2->second.attempt < cfg_.max_attempts && schedule_retry( req_id, & it_2->second ) )
+        {
+            should_forward = false;
+        }
+        else
+        {
+            if( is_retryable )
+                num_retries_exhausted_++;
+
+            map_req_id_to_retry_info_.erase( it_2 );
+        }
+    }
+
+    if( should_forward )
+        num_failed_++;
+
+    process_jobs();
+
+    return should_forward;
+}
+
+bool CallManager::schedule_retry( uint32_t req_id, RetryInfo * info )
+{
+    auto delay = get_retry_delay( info->attempt );
+
+    scheduler::Time exec_time = get_now() + std::chrono::milliseconds( delay );
+
+    scheduler::job_id_t job_id;
+
+    std::string error_msg;
+
+    auto b = scheduler::create_and_insert_one_time_job(
+            & job_id, "retry " + std::to_string( req_id ), sched_, exec_time,
+            std::bind( & CallManager::on_retry_job, retry_guard_, this, req_id ), & error_msg );
+
+    if( b == false )
+    {
+        dummy_log_error( log_id_, "request %u: cannot schedule retry: %s", req_id, error_msg.c_str() );
+        return false;
+    }
+
+    map_req_id_to_retry_job_id_[ req_id ] = job_id;
+
+    num_retries_++;
+    total_retry_delay_  += delay;
+
+    dummy_log_debug( log_id_, "request %u: attempt %u failed, retry in %u ms", req_id, info->attempt, delay );
+
+    return true;
+}
+
+void CallManager::on_retry_job( std::shared_ptr<RetryGuard> guard, CallManager * self, uint32_t req_id )
+{
+    MUTEX_SCOPE_LOCK( guard->mutex );
+
+    if( guard->is_alive )
+        self->on_retry_due( req_id );
+}
+
+void CallManager::delete_retry_jobs( const JobIds & job_ids )
+{
+    // private: must be called without mutex lock, the scheduler may be executing a job waiting for it
+
+    for( auto job_id : job_ids )
+    {
+        std::string error_msg;
+
+        sched_->delete_job( job_id, & error_msg );
+    }
+}
+
+void CallManager::on_retry_due( uint32_t req_id )
+{
+    MUTEX_SCOPE_LOCK( mutex_ );
+
+    if( map_req_id_to_retry_job_id_.erase( req_id ) == 0 )
+        return;
+
+    auto it = map_req_id_to_retry_info_.find( req_id );
+
+    if( it == map_req_id_to_retry_info_.end() )
+    {
+        dummy_log_error( log_id_, "request %u: no retry info", req_id );
+        return;
+    }
+
+    dummy_log_debug( log_id_, "request %u: retry is due, attempt %u", req_id, it->second.attempt + 1 );
+
+    push_pending( simple_voip::create_initiate_call_request( req_id, it->second.party ) );
+
+    process_jobs();
+}
+
+uint32_t CallManager::get_retry_delay( uint32_t attempt )
+{
+    // exponential backoff with equal jitter: half of the delay is fixed, the other half is random
+
+    uint64_t delay = cfg_.retry_delay_min;
+
+    for( uint32_t i = 1; i < attempt && delay < cfg_.retry_delay_max; ++i )
+        delay *= 2;
+
+    delay = std::min<uint64_t>( delay, cfg_.retry_delay_max );
+
+    return delay / 2 + std::uniform_int_distribution<uint32_t>( 0, delay - delay / 2 )( rng_ );
 }
 
 void CallManager::handle_failed_call( uint32_t call_id )
@@ -363,6 +1093,8 @@ void CallManager::handle_failed_call( uint32_t call_id )
         return;
     }
 
+    on_slot_released( it->second );
+
     active_call_ids_.erase( it );
 
     process_jobs();
@@ -385,8 +1117,25 @@ uint32_t CallManager::get_num_of_activities() const
 
 void CallManager::log_stat()
 {
-    dummy_log_debug( log_id_, "stat: active calls %u, active requests %u, pending requests %u",
-            active_call_ids_.size(), active_request_ids_.size(), request_queue_.size() );
+    dummy_log_debug( log_id_, "stat: active calls %u, active requests %u, pending requests %u, mean slot time %u ms, waiting retries %u, retries %llu (exhausted %llu, avg delay %llu ms)",
+            active_call_ids_.size(), active_request_ids_.size(), request_queue_.size(), static_cast<uint32_t>( mean_slot_time_ ), map_req_id_to_retry_job_id_.size(),
+            num_retries_, num_retries_exhausted_, num_retries_ ? total_retry_delay_ / num_retries_ : 0ULL );
+
+    CallStats s;
+
+    s.max_active_calls      = cfg_.max_active_calls;
+    s.active_calls          = active_call_ids_.size();
+    s.active_requests       = active_request_ids_.size();
+    s.pending_requests      = request_queue_.size();
+    s.waiting_retries       = map_req_id_to_retry_job_id_.size();
+    s.num_dispatched        = num_dispatched_;
+    s.num_established       = num_established_;
+    s.num_failed            = num_failed_;
+    s.num_retries           = num_retries_;
+    s.num_retries_exhausted = num_retries_exhausted_;
+    s.total_retry_delay     = total_retry_delay_;
+
+    stats_publisher_.publish( s );
 }
 
 
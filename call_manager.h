@@ -26,14 +26,24 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 #define CALL_MANAGER_H
 
 #include <list>                             // std::list
+#include <vector>                           // std::vector
 #include <mutex>                            // std::mutex
+#include <condition_variable>               // std::condition_variable
 #include <map>                              // std::map
-#include <set>                              // std::set
+#include <chrono>                           // std::chrono::system_clock
+#include <random>                           // std::mt19937
+#include <memory>                           // std::shared_ptr
 
 #include "config.h"                         // Config
+#include "i_clock.h"                        // IClock
+#include "i_dial_list.h"                    // IDialList
+#include "i_queue_callback.h"               // IQueueCallback
+#include "stats_page.h"                     // StatsPublisher
+#include "pending_requests.h"               // PendingRequests
 #include "simple_voip/objects.h"            // simple_voip::InitiateCallRequest
 #include "simple_voip/i_simple_voip.h"      // simple_voip::ISimpleVoip
 #include "simple_voip/i_simple_voip_callback.h" // ISimpleVoipCallback
+#include "scheduler/i_scheduler.h"          // scheduler::IScheduler
 
 #include "namespace_lib.h"              // NAMESPACE_CALMAN_START
 
@@ -41,6 +51,15 @@ NAMESPACE_CALMAN_START
 
 class CallManager;
 
+// The callbacks (ISimpleVoipCallback, IQueueCallback) are called in the order CallManager
+// generated them and never at the same time. By default they are called under the lock of
+// CallManager, so they must not call it back.
+//
+// With Config::unlocked_callbacks they are called without the lock and may call CallManager
+// back, e.g. to issue the next request. One thread at a time delivers them: a thread that finds
+// another one delivering leaves its callbacks to that one, so a request answered at once
+// (draining, estimated wait too long, req_id reserved by the dial list) may be answered on
+// another thread and after consume() has returned.
 class CallManager:
     virtual public simple_voip::ISimpleVoip,
     virtual public simple_voip::ISimpleVoipCallback
@@ -56,6 +75,35 @@ public:
             const Config                        & cfg,
             std::string                         * error_msg );
 
+    // sched is used for retries, required if cfg.max_attempts > 1
+    bool init(
+            unsigned int                        log_id,
+            simple_voip::ISimpleVoip            * voips,
+            simple_voip::ISimpleVoipCallback    * callback,
+            scheduler::IScheduler               * sched,
+            const Config                        & cfg,
+            std::string                         * error_msg );
+
+    // campaign source, pulled when there are free slots and no pending requests; nullptr detaches;
+    // fails if the id range of the list overlaps requests in use, see IDialList
+    bool set_dial_list( IDialList * dial_list, std::string * error_msg );
+
+    // receives positions of queued requests; nullptr detaches
+    void set_queue_callback( IQueueCallback * queue_callback );
+
+    // returns false if the request is not in the pending queue; estimated_wait_ms is UNKNOWN_WAIT
+    // until the first slot is released
+    bool get_queue_position( uint32_t req_id, uint32_t * position, uint32_t * estimated_wait_ms ) const;
+
+    // takes over requests exported by a drained instance; fails and imports nothing if a req_id
+    // is duplicated, in use or reserved by the dial list
+    bool import_pending( const PendingRequests & reqs, std::string * error_msg );
+
+    // stops admitting new calls, answers pending requests according to the policy
+    // and waits up to timeout for active calls to end; returns false on timeout;
+    // with EXPORT the pending requests are moved to 'exported', which must not be nullptr
+    bool drain( drain_policy_e policy, uint32_t timeout_ms, PendingRequests * exported );
+
     // interface ISimpleVoip
     void consume( const simple_voip::ForwardObject* obj );
 
@@ -63,16 +111,55 @@ public:
     void consume( const simple_voip::CallbackObject * obj );
 
     // interface threcon::IControllable
+    // drains with the policy of the config; if EXPORT cannot save the requests, they are rejected
     bool shutdown();
 
 private:
 
+    struct QueuedNotice
+    {
+        IQueueCallback      * callback;
+        uint32_t            req_id;
+        uint32_t            position;
+        uint32_t            estimated_wait_ms;
+    };
+
+    // callback generated under the lock: an object for callback_ or, if obj is nullptr, a notice
+    struct DeferredCallback
+    {
+        const simple_voip::CallbackObject   * obj;
+        QueuedNotice                        notice;
+    };
+
+    typedef std::vector<DeferredCallback>   DeferredCallbacks;
+
     typedef std::list<const simple_voip::InitiateCallRequest*>  RequestQueue;
 
-    typedef std::set<uint32_t>              SetReqIds;
-    typedef std::set<uint32_t>              SetCallIds;
+    typedef scheduler::Time                 Time;
+
+    // id to the time its slot was taken
+    typedef std::map<uint32_t, Time>        MapReqIdToStartTime;
+    typedef std::map<uint32_t, Time>        MapCallIdToStartTime;
+    typedef std::map<uint32_t, uint64_t>    MapReqIdToQueueSeq;
     typedef std::map<uint32_t, uint32_t>    MapReqIdToCallId;
 
+    struct RetryInfo
+    {
+        std::string         party;
+        uint32_t            attempt;    // 1 - first attempt
+    };
+
+    typedef std::map<uint32_t, RetryInfo>               MapReqIdToRetryInfo;
+    typedef std::map<uint32_t, scheduler::job_id_t>     MapReqIdToJobId;
+    typedef std::vector<scheduler::job_id_t>            JobIds;
+
+    // shared with the retry jobs, so that a job executed while CallManager is destroyed does not touch it
+    struct RetryGuard
+    {
+        std::mutex          mutex;
+        bool                is_alive;
+    };
+
 private:
 
     void process( const simple_voip::InitiateCallRequest * req );
@@ -81,25 +168,54 @@ private:
     void handle_InitiateCallRequest( const simple_voip::ForwardObject * req );
     void handle_DropRequest( const simple_voip::ForwardObject * req );
 
-    // interface ISimpleVoipCallback
-    void handle_InitiateCallResponse( const simple_voip::CallbackObject * obj );
-    void handle_RejectResponse( const simple_voip::CallbackObject * obj );
-    void handle_ErrorResponse( const simple_voip::CallbackObject * obj );
-    void handle_DropResponse( const simple_voip::CallbackObject * obj );
-    void handle_ConnectionLost( const simple_voip::CallbackObject * obj );
-    void handle_Failed( const simple_voip::CallbackObject * obj );
+    // interface ISimpleVoipCallback, return false if the object must not be forwarded to the callback
+    bool handle_InitiateCallResponse( const simple_voip::CallbackObject * obj );
+    bool handle_RejectResponse( const simple_voip::CallbackObject * obj );
+    bool handle_ErrorResponse( const simple_voip::CallbackObject * obj );
+    bool handle_DropResponse( const simple_voip::CallbackObject * obj );
+    bool handle_ConnectionLost( const simple_voip::CallbackObject * obj );
+    bool handle_Failed( const simple_voip::CallbackObject * obj );
 
+    bool handle_failed_request( uint32_t req_id, bool is_retryable );
     void erase_failed_drop_request( uint32_t req_id );
     void handle_failed_call( uint32_t call_id );
 
+    bool schedule_retry( uint32_t req_id, RetryInfo * info );
+    static void on_retry_job( std::shared_ptr<RetryGuard> guard, CallManager * self, uint32_t req_id );
+    void on_retry_due( uint32_t req_id );
+    void delete_retry_jobs( const JobIds & job_ids );
+    uint32_t get_retry_delay( uint32_t attempt );
+
     uint32_t get_num_of_activities() const;
 
+    bool is_req_id_range_in_use( uint32_t first_req_id, uint32_t num_req_ids ) const;
+    bool is_reserved_by_dial_list( uint32_t req_id ) const;
+
     void process_jobs();
 
+    void push_pending( const simple_voip::InitiateCallRequest * req );
+    const simple_voip::InitiateCallRequest * pop_pending();
+    void clear_pending();
+
+    Time get_now() const;
+
+    void on_slot_released( const Time & start );
+    uint32_t get_estimated_wait( uint32_t position ) const;
+
+    void take_pending_for_drain( drain_policy_e policy, PendingRequests * exported, JobIds * job_ids );
+    void reject_exported( const PendingRequests & exported );
+    void reject_request( uint32_t req_id, const char * reason );
+    void defer( const simple_voip::CallbackObject * obj );
+    void defer( const QueuedNotice & notice );
+    void deliver( std::unique_lock<std::mutex> & lock );
+
+    bool take_next_job( const simple_voip::InitiateCallRequest ** req );
+
     void log_stat();
 
 private:
     mutable std::mutex          mutex_;
+    std::condition_variable     cond_;
 
     unsigned int                log_id_;
 
@@ -107,12 +223,49 @@ private:
 
     RequestQueue                request_queue_;
 
+    // the queue is strictly FIFO, so a position is the distance from the sequence number of the head
+    MapReqIdToQueueSeq          map_req_id_to_queue_seq_;
+    uint64_t                    next_queue_seq_;
+    uint64_t                    head_queue_seq_;
+
+    double                      mean_slot_time_;    // ms, moving average of how long a slot is held
+    uint64_t                    num_slot_samples_;
+
+    IQueueCallback              * queue_callback_;
+
+    bool                        is_draining_;
+
+    IDialList                   * dial_list_;
+
     simple_voip::ISimpleVoip  * voips_;
     simple_voip::ISimpleVoipCallback        * callback_;
 
-    SetReqIds                   active_request_ids_;
-    SetCallIds                  active_call_ids_;
+    DeferredCallbacks           deferred_;
+    bool                        is_delivering_;     // with unlocked_callbacks only
+
+    scheduler::IScheduler       * sched_;
+    IClock                      * clock_;   // nullptr - wall clock
+
+    MapReqIdToStartTime         active_request_ids_;
+    MapCallIdToStartTime        active_call_ids_;
     MapReqIdToCallId            map_drop_req_id_to_call_id_;
+
+    MapReqIdToRetryInfo         map_req_id_to_retry_info_;
+    MapReqIdToJobId             map_req_id_to_retry_job_id_;
+
+    std::shared_ptr<RetryGuard> retry_guard_;
+
+    std::mt19937                rng_;
+
+    uint64_t                    num_retries_;
+    uint64_t                    num_retries_exhausted_;
+    uint64_t                    total_retry_delay_;     // ms
+
+    uint64_t                    num_dispatched_;
+    uint64_t                    num_established_;
+    uint64_t                    num_failed_;
+
+    StatsPublisher              stats_publisher_;
 };
 
 NAMESPACE_CALMAN_END
@@ -26,13 +26,37 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 #define CALMAN_CONFIG_H
 
 #include <cstdint>                  // uint32_t
+#include <string>                   // std::string
+#include <set>                      // std::set
 #include "namespace_lib.h"          // NAMESPACE_CALMAN_START
 
 NAMESPACE_CALMAN_START
 
+enum class drain_policy_e
+{
+    REJECT,     // pending requests are answered with RejectResponse
+    EXPORT,     // pending requests are handed over to the next instance
+};
+
 struct Config
 {
-    uint32_t    max_active_calls;    // 1
+    uint32_t    max_active_calls    = 1;
+
+    uint32_t    max_attempts        = 1;        // 1 - no retries
+    uint32_t    retry_delay_min     = 1000;     // ms, backoff before the first retry
+    uint32_t    retry_delay_max     = 60000;    // ms, backoff is doubled per attempt up to this value
+    std::set<uint32_t>  retry_reject_codes;     // errorcodes of RejectResponse worth a retry, others are permanent
+    std::set<uint32_t>  retry_error_codes;      // errorcodes of ErrorResponse worth a retry, others are permanent
+
+    uint32_t    max_estimated_wait  = 0;        // ms, 0 - off, requests expected to wait longer in the queue are rejected
+
+    std::string stats_shm_name;                 // e.g. "/calman_stats", empty - stats are not published; unique per instance
+
+    bool        unlocked_callbacks  = false;    // the callbacks are called without the lock and may call back, see CallManager
+
+    drain_policy_e  drain_policy    = drain_policy_e::REJECT;   // applied in shutdown()
+    uint32_t    drain_timeout       = 30000;    // ms, how long shutdown() waits for active calls
+    std::string drain_export_file   = "pending.txt";    // where shutdown() saves exported requests
 };
 
 NAMESPACE_CALMAN_END
@@ -0,0 +1,388 @@
+/*
+
+Coroutine client of the call manager.
+
+Copyright (C) 2020 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+// $Revision: 13958 $ $Date:: 2020-10-05 #$ $Author: serge $
+
+// Optional, header only, requires C++20:
+//
+//  calman::CoroTask dial( calman::CoroClient & client, std::string party )
+//  {
+//      auto res = co_await client.initiate_call( party );
+//
+//      if( res.status == calman::CallResult::status_e::OK )
+//          co_await client.drop_call( res.call_id );
+//  }
+//
+// CallManager must be inited with Config::unlocked_callbacks = true: the
+// coroutine is resumed on the thread that delivers the response and issues its
+// next request from there. A request answered before the coroutine suspends
+// (e.g. rejected while draining) does not suspend it at all.
+// See coro_example/ for a complete program.
+
+#ifndef CALMAN_CORO_CLIENT_H
+#define CALMAN_CORO_CLIENT_H
+
+#if __cplusplus < 202002L
+#error "coro_client.h requires C++20"
+#endif
+
+#include <atomic>                                   // std::atomic
+#include <coroutine>                                // std::coroutine_handle
+#include <exception>                                // std::terminate
+#include <mutex>                                    // std::mutex
+#include <string>                                   // std::string
+#include <vector>                                   // std::vector
+
+#include "simple_voip/objects.h"                    // simple_voip::InitiateCallResponse
+#include "simple_voip/object_factory.h"             // simple_voip::create_initiate_call_request
+#include "simple_voip/i_simple_voip.h"              // simple_voip::ISimpleVoip
+#include "simple_voip/i_simple_voip_callback.h"     // simple_voip::ISimpleVoipCallback
+
+#include "namespace_lib.h"                          // NAMESPACE_CALMAN_START
+
+NAMESPACE_CALMAN_START
+
+struct CallResult
+{
+    enum class status_e
+    {
+        OK,
+        REJECTED,
+        ERROR,
+    };
+
+    status_e        status;
+    uint32_t        call_id;        // if OK
+    uint32_t        errorcode;      // if REJECTED or ERROR
+    std::string     descr;
+};
+
+class CoroClient;
+
+// Request waiting for its response. Lives in the coroutine frame and is linked
+// into the table of CoroClient, so awaiting allocates nothing by itself.
+class PendingOp
+{
+public:
+
+    PendingOp( const PendingOp & )              = delete;
+    PendingOp & operator=( const PendingOp & )  = delete;
+
+    ~PendingOp()
+    {
+        delete response_;
+    }
+
+    bool await_ready() const noexcept
+    {
+        return false;
+    }
+
+protected:
+
+    PendingOp( CoroClient * client, uint32_t req_id ):
+        client_( client ),
+        req_id_( req_id ),
+        next_( nullptr ),
+        response_( nullptr ),
+        state_( state_e::IDLE )
+    {
+    }
+
+    // returns false if the response came before the coroutine could suspend
+    bool suspend( std::coroutine_handle<> handle, const simple_voip::ForwardObject * req );
+
+    CallResult get_result() const
+    {
+        CallResult res = { CallResult::status_e::ERROR, 0, 0, std::string() };
+
+        if( auto * r = dynamic_cast<const simple_voip::InitiateCallResponse *>( response_ ) )
+        {
+            res.status      = CallResult::status_e::OK;
+            res.call_id     = r->call_id;
+        }
+        else if( dynamic_cast<const simple_voip::DropResponse *>( response_ ) )
+        {
+            res.status      = CallResult::status_e::OK;
+        }
+        else if( auto * r = dynamic_cast<const simple_voip::RejectResponse *>( response_ ) )
+        {
+            res.status      = CallResult::status_e::REJECTED;
+            res.errorcode   = r->errorcode;
+            res.descr       = r->descr;
+        }
+        else if( auto * r = dynamic_cast<const simple_voip::ErrorResponse *>( response_ ) )
+        {
+            res.errorcode   = r->errorcode;
+            res.descr       = r->descr;
+        }
+
+        return res;
+    }
+
+protected:
+
+    friend class CoroClient;
+
+    enum class state_e
+    {
+        IDLE,
+        SUSPENDED,
+        DONE,
+    };
+
+    CoroClient                          * client_;
+    uint32_t                            req_id_;
+    PendingOp                           * next_;
+    std::coroutine_handle<>             handle_;
+    const simple_voip::CallbackObject   * response_;
+    std::atomic<state_e>                state_;
+};
+
+class InitiateCallAwaiter: public PendingOp
+{
+public:
+    InitiateCallAwaiter( CoroClient * client, uint32_t req_id, std::string party ):
+        PendingOp( client, req_id ),
+        party_( std::move( party ) )
+    {
+    }
+
+    bool await_suspend( std::coroutine_handle<> handle )
+    {
+        return suspend( handle, simple_voip::create_initiate_call_request( req_id_, party_ ) );
+    }
+
+    CallResult await_resume() const
+    {
+        return get_result();
+    }
+
+private:
+    std::string     party_;
+};
+
+class DropAwaiter: public PendingOp
+{
+public:
+    DropAwaiter( CoroClient * client, uint32_t req_id, uint32_t call_id ):
+        PendingOp( client, req_id ),
+        call_id_( call_id )
+    {
+    }
+
+    bool await_suspend( std::coroutine_handle<> handle )
+    {
+        return suspend( handle, simple_voip::create_drop_request( req_id_, call_id_ ) );
+    }
+
+    CallResult await_resume() const
+    {
+        return get_result();
+    }
+
+private:
+    uint32_t        call_id_;
+};
+
+// Callback of CallManager, which resumes the coroutines waiting for responses; requires unlocked_callbacks.
+// Objects nobody waits for (call events, responses to plain requests) go to the fallback callback.
+class CoroClient: virtual public simple_voip::ISimpleVoipCallback
+{
+public:
+    CoroClient():
+        calman_( nullptr ),
+        fallback_( nullptr ),
+        mask_( 0 ),
+        last_req_id_( 0 )
+    {
+    }
+
+    // num_buckets must be a power of 2, about the expected number of concurrent requests
+    bool init(
+            simple_voip::ISimpleVoip            * calman,
+            simple_voip::ISimpleVoipCallback    * fallback,
+            uint32_t                            first_req_id,
+            uint32_t                            num_buckets,
+            std::string                         * error_msg )
+    {
+        if( calman == nullptr || fallback == nullptr )
+        {
+            * error_msg = "calman and fallback must be set";
+            return false;
+        }
+
+        if( num_buckets == 0 || ( num_buckets & ( num_buckets - 1 ) ) != 0 )
+        {
+            * error_msg = "num_buckets is not a power of 2";
+            return false;
+        }
+
+        calman_         = calman;
+        fallback_       = fallback;
+        last_req_id_    = first_req_id;
+        mask_           = num_buckets - 1;
+
+        buckets_.assign( num_buckets, nullptr );
+
+        return true;
+    }
+
+    InitiateCallAwaiter initiate_call( std::string party )
+    {
+        return InitiateCallAwaiter( this, ++last_req_id_, std::move( party ) );
+    }
+
+    DropAwaiter drop_call( uint32_t call_id )
+    {
+        return DropAwaiter( this, ++last_req_id_, call_id );
+    }
+
+    // interface ISimpleVoipCallback
+    void consume( const simple_voip::CallbackObject * obj )
+    {
+        uint32_t req_id;
+
+        PendingOp * op = get_req_id( obj, & req_id ) ? extract( req_id ) : nullptr;
+
+        if( op == nullptr )
+        {
+            fallback_->consume( obj );
+            return;
+        }
+
+        op->response_ = obj;
+
+        if( op->state_.exchange( PendingOp::state_e::DONE ) == PendingOp::state_e::SUSPENDED )
+            op->handle_.resume();
+    }
+
+private:
+
+    friend class PendingOp;
+
+    static bool get_req_id( const simple_voip::CallbackObject * obj, uint32_t * req_id )
+    {
+        if( auto * r = dynamic_cast<const simple_voip::InitiateCallResponse *>( obj ) )
+            * req_id = r->req_id;
+        else if( auto * r = dynamic_cast<const simple_voip::RejectResponse *>( obj ) )
+            * req_id = r->req_id;
+        else if( auto * r = dynamic_cast<const simple_voip::ErrorResponse *>( obj ) )
+            * req_id = r->req_id;
+        else if( auto * r = dynamic_cast<const simple_voip::DropResponse *>( obj ) )
+            * req_id = r->req_id;
+        else
+            return false;
+
+        return true;
+    }
+
+    void insert( PendingOp * op )
+    {
+        std::lock_guard<std::mutex> lock( mutex_ );
+
+        auto & head = buckets_[ op->req_id_ & mask_ ];
+
+        op->next_   = head;
+        head        = op;
+    }
+
+    PendingOp * extract( uint32_t req_id )
+    {
+        std::lock_guard<std::mutex> lock( mutex_ );
+
+        for( auto ** p = & buckets_[ req_id & mask_ ]; * p; p = & ( * p )->next_ )
+        {
+            if( ( * p )->req_id_ == req_id )
+            {
+                auto * res = * p;
+
+                * p = res->next_;
+
+                return res;
+            }
+        }
+
+        return nullptr;
+    }
+
+private:
+    simple_voip::ISimpleVoip            * calman_;
+    simple_voip::ISimpleVoipCallback    * fallback_;
+
+    std::mutex                          mutex_;
+    std::vector<PendingOp*>             buckets_;
+    uint32_t                            mask_;
+
+    std::atomic<uint32_t>               last_req_id_;
+};
+
+inline bool PendingOp::suspend( std::coroutine_handle<> handle, const simple_voip::ForwardObject * req )
+{
+    handle_ = handle;
+
+    client_->insert( this );
+
+    client_->calman_->consume( req );
+
+    // the response may be delivered during consume() or on another thread right after it,
+    // whoever comes second resumes the coroutine
+
+    auto expected = state_e::IDLE;
+
+    return state_.compare_exchange_strong( expected, state_e::SUSPENDED );
+}
+
+// Coroutine type that starts at once and is not awaited by anybody.
+struct CoroTask
+{
+    struct promise_type
+    {
+        CoroTask get_return_object() noexcept
+        {
+            return CoroTask();
+        }
+
+        std::suspend_never initial_suspend() noexcept
+        {
+            return std::suspend_never();
+        }
+
+        std::suspend_never final_suspend() noexcept
+        {
+            return std::suspend_never();
+        }
+
+        void return_void() noexcept
+        {
+        }
+
+        void unhandled_exception() noexcept
+        {
+            std::terminate();
+        }
+    };
+};
+
+NAMESPACE_CALMAN_END
+
+#endif  // CALMAN_CORO_CLIENT_H
@@ -0,0 +1,182 @@
+/*
+
+Example of the coroutine client.
+
+Copyright (C) 2020 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// $Revision: 13958 $ $Date:: 2020-10-05 #$ $Author: serge $
+
+#include <iostream>         // cout
+#include <atomic>           // std::atomic
+#include <thread>           // std::this_thread::sleep_for
+#include <chrono>           // std::chrono::milliseconds
+#include <mutex>            // std::mutex
+
+#include "../call_manager.h"                    // calman::CallManager
+#include "../coro_client.h"                     // calman::CoroClient
+#include "simple_voip/objects.h"
+#include "simple_voip/str_helper.h"
+#include "simple_voip/i_simple_voip_callback.h" // simple_voip::ISimpleVoipCallback
+
+#include "simple_voip_dummy/dummy.h"            // simple_voip_dummy::Dummy
+#include "simple_voip_dummy/init_config.h"      // simple_voip_dummy::init_config
+
+#include "utils/dummy_logger.h"                 // dummy_log_set_log_level
+#include "scheduler/scheduler.h"                // Scheduler
+
+std::mutex          g_cout_mutex;
+std::atomic<int>    g_num_done( 0 );
+
+// receives the objects no coroutine waits for, i.e. call events
+class Fallback: virtual public simple_voip::ISimpleVoipCallback
+{
+public:
+    // interface ISimpleVoipCallback
+    void consume( const simple_voip::CallbackObject * obj )
+    {
+        {
+            std::lock_guard<std::mutex> lock( g_cout_mutex );
+
+            std::cout << "event " << *obj << std::endl;
+        }
+
+        delete obj;
+    }
+};
+
+const char * to_string( calman::CallResult::status_e s )
+{
+    switch( s )
+    {
+    case calman::CallResult::status_e::OK:          return "OK";
+    case calman::CallResult::status_e::REJECTED:    return "REJECTED";
+    default:                                        return "ERROR";
+    }
+}
+
+calman::CoroTask dial( calman::CoroClient & client, std::string party )
+{
+    auto res = co_await client.initiate_call( party );
+
+    {
+        std::lock_guard<std::mutex> lock( g_cout_mutex );
+
+        std::cout << party << ": initiate " << to_string( res.status ) << " call_id " << res.call_id << " " << res.descr << std::endl;
+    }
+
+    if( res.status == calman::CallResult::status_e::OK )
+    {
+        auto drop = co_await client.drop_call( res.call_id );
+
+        std::lock_guard<std::mutex> lock( g_cout_mutex );
+
+        std::cout << party << ": drop " << to_string( drop.status ) << " " << drop.descr << std::endl;
+    }
+
+    g_num_done++;
+}
+
+int main( int argc, char **argv )
+{
+    if( argc < 2 )
+    {
+        std::cerr << "USAGE: coro_example <party> [<party> ...]" << std::endl;
+
+        return EXIT_FAILURE;
+    }
+
+    int num_parties = argc - 1;
+
+    config_reader::ConfigReader cr;
+
+    std::string config_file( "../voip_config.ini" );
+
+    cr.init( config_file );
+
+    simple_voip_dummy::Config config;
+
+    simple_voip_dummy::init_config( & config, cr );
+
+    auto log_id_calman      = dummy_logger::register_module( "CallManager" );
+    auto log_id_dummy       = dummy_logger::register_module( "SimpleVoipDummy" );
+    auto log_id_call        = dummy_logger::register_module( "Call" );
+    auto log_id_sched       = dummy_logger::register_module( "Scheduler" );
+
+    dummy_logger::set_log_level( log_id_calman,     log_levels_log4j::INFO );
+    dummy_logger::set_log_level( log_id_dummy,      log_levels_log4j::INFO );
+    dummy_logger::set_log_level( log_id_call,       log_levels_log4j::INFO );
+    dummy_logger::set_log_level( log_id_sched,      log_levels_log4j::INFO );
+
+    simple_voip_dummy::Dummy        dialer;
+    scheduler::Scheduler            sched( scheduler::Duration( std::chrono::milliseconds( 1 ) ) );
+    calman::CallManager             calman;
+    calman::CoroClient              client;
+    Fallback                        fallback;
+
+    calman::Config                  cfg;
+
+    cfg.max_active_calls   = 2;
+    cfg.max_attempts       = 1;
+    cfg.retry_delay_min    = 1000;
+    cfg.retry_delay_max    = 60000;
+    cfg.max_estimated_wait = 0;
+    cfg.drain_policy       = calman::drain_policy_e::REJECT;
+    cfg.drain_timeout      = 5000;
+    cfg.unlocked_callbacks = true;         // coroutines issue requests from the callback
+
+    sched.init_log( log_id_sched );
+
+    std::string error_msg;
+
+    if( client.init( & calman, & fallback, 0, 64, & error_msg ) == false )
+    {
+        std::cout << "cannot initialize coroutine client: " << error_msg << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if( dialer.init( log_id_dummy, log_id_call, config, & calman, & sched, & error_msg ) == false )
+    {
+        std::cout << "cannot initialize voip module: " << error_msg << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if( calman.init( log_id_calman, & dialer, & client, & sched, cfg, & error_msg ) == false )
+    {
+        std::cout << "cannot initialize Calman: " << error_msg << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    dialer.start();
+
+    sched.run();
+
+    // more parties than slots, the rest wait in the pending queue of CallManager
+    for( int i = 1; i < argc; ++i )
+        dial( client, argv[i] );
+
+    while( g_num_done < num_parties )
+        std::this_thread::sleep_for( std::chrono::milliseconds( 100 ) );
+
+    calman.shutdown();
+    dialer.shutdown();
+    sched.shutdown();
+
+    std::cout << "Done! =)" << std::endl;
+
+    return 0;
+}
@@ -180,6 +180,15 @@ int main( int argc, char **argv )
     calman::Config              cfg;
 
     cfg.max_active_calls   = max_active_calls;
+    cfg.max_attempts       = 1;
+    cfg.retry_delay_min    = 1000;
+    cfg.retry_delay_max    = 60000;
+    cfg.retry_reject_codes = {};
+    cfg.retry_error_codes  = {};
+    cfg.max_estimated_wait = 0;
+    cfg.stats_shm_name     = "/calman_stats";
+    cfg.drain_policy       = calman::drain_policy_e::REJECT;
+    cfg.drain_timeout      = 5000;
 
     simple_voip_dummy::Config config;
 
@@ -217,7 +226,7 @@ int main( int argc, char **argv )
     }
 
     {
-        bool b = calman.init( log_id_calman, & dialer, & test, cfg, & error_msg );
+        bool b = calman.init( log_id_calman, & dialer, & test, & sched, cfg, & error_msg );
         if( !b )
         {
             std::cout << "cannot initialize Calman: " << error_msg << std::endl;
@@ -236,8 +245,8 @@ int main( int argc, char **argv )
     for( auto & t : tg )
         t.join();
 
-    dialer.shutdown();
     calman.shutdown();
+    dialer.shutdown();
     sched.shutdown();
 
     std::cout << "Done! =)" << std::endl;
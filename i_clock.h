@@ -0,0 +1,47 @@
+/*
+
+Clock interface.
+
+Copyright (C) 2020 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+// $Revision: 13958 $ $Date:: 2020-10-05 #$ $Author: serge $
+
+#ifndef CALMAN_I_CLOCK_H
+#define CALMAN_I_CLOCK_H
+
+#include "scheduler/i_scheduler.h"  // scheduler::Time
+
+#include "namespace_lib.h"          // NAMESPACE_CALMAN_START
+
+NAMESPACE_CALMAN_START
+
+// Source of the current time. CallManager takes its time from the scheduler it is given
+// if the scheduler implements IClock as well (e.g. the virtual time scheduler of a simulation),
+// and from the wall clock otherwise.
+class IClock
+{
+public:
+    virtual ~IClock() {}
+
+    virtual scheduler::Time get_now() const = 0;
+};
+
+NAMESPACE_CALMAN_END
+
+#endif  // CALMAN_I_CLOCK_H
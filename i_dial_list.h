@@ -0,0 +1,56 @@
+/*
+
+Dial list interface.
+
+Copyright (C) 2020 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+// $Revision: 13958 $ $Date:: 2020-10-05 #$ $Author: serge $
+
+#ifndef CALMAN_I_DIAL_LIST_H
+#define CALMAN_I_DIAL_LIST_H
+
+#include <cstdint>                  // uint32_t
+#include <string>                   // std::string
+
+#include "namespace_lib.h"          // NAMESPACE_CALMAN_START
+
+NAMESPACE_CALMAN_START
+
+// Source of parties for a campaign. CallManager pulls the next entry only
+// when it has a free slot, so entries are materialized one at a time.
+//
+// The request ids of the list must not overlap the ids of other sources
+// (client requests, imported requests, other lists): CallManager refuses to
+// attach a list whose range holds ids in use and rejects client requests
+// with an id inside the range of the attached list.
+class IDialList
+{
+public:
+    virtual ~IDialList() {}
+
+    // returns false if the list is exhausted or cancelled
+    virtual bool get_next( uint32_t * req_id, std::string * party ) = 0;
+
+    // ids the list is still going to hand out: [first_req_id, first_req_id + num_req_ids)
+    virtual void get_req_id_range( uint32_t * first_req_id, uint32_t * num_req_ids ) const = 0;
+};
+
+NAMESPACE_CALMAN_END
+
+#endif  // CALMAN_I_DIAL_LIST_H
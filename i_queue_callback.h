@@ -0,0 +1,50 @@
+/*
+
+Queue callback interface.
+
+Copyright (C) 2020 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+// $Revision: 13958 $ $Date:: 2020-10-05 #$ $Author: serge $
+
+#ifndef CALMAN_I_QUEUE_CALLBACK_H
+#define CALMAN_I_QUEUE_CALLBACK_H
+
+#include <cstdint>                  // uint32_t
+
+#include "namespace_lib.h"          // NAMESPACE_CALMAN_START
+
+NAMESPACE_CALMAN_START
+
+// estimated wait before the first slot is released, there is nothing to base an estimate on
+const uint32_t UNKNOWN_WAIT = UINT32_MAX;
+
+class IQueueCallback
+{
+public:
+    virtual ~IQueueCallback() {}
+
+    // request was put into the pending queue, position 0 is the next one to be dispatched,
+    // estimated_wait_ms may be UNKNOWN_WAIT;
+    // called in order with the other callbacks, see the callback notes of CallManager
+    virtual void on_queued( uint32_t req_id, uint32_t position, uint32_t estimated_wait_ms ) = 0;
+};
+
+NAMESPACE_CALMAN_END
+
+#endif  // CALMAN_I_QUEUE_CALLBACK_H
@@ -0,0 +1,227 @@
+/*
+
+Memory-mapped dial list.
+
+Copyright (C) 2020 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+// $Revision: 13958 $ $Date:: 2020-10-05 #$ $Author: serge $
+
+#include "mmap_dial_list.h"             // self
+
+#include <cstring>                      // memchr, strerror
+#include <cerrno>                       // errno
+#include <cstdint>                      // UINT32_MAX
+#include <fcntl.h>                      // open
+#include <unistd.h>                     // close
+#include <sys/mman.h>                   // mmap
+#include <sys/stat.h>                   // fstat
+
+#include "utils/mutex_helper.h"         // MUTEX_SCOPE_LOCK
+
+NAMESPACE_CALMAN_START
+
+MmapDialList::MmapDialList():
+    data_( nullptr ),
+    size_( 0 ),
+    first_req_id_( 0 ),
+    num_entries_( 0 ),
+    cursor_( { 0, 0 } ),
+    is_cancelled_( false )
+{
+}
+
+MmapDialList::~MmapDialList()
+{
+    if( data_ != nullptr )
+        munmap( const_cast<char*>( data_ ), size_ );
+}
+
+bool MmapDialList::init(
+        const std::string   & filename,
+        uint32_t            first_req_id,
+        const Cursor        & start,
+        std::string         * error_msg )
+{
+    MUTEX_SCOPE_LOCK( mutex_ );
+
+    if( data_ != nullptr )
+    {
+        * error_msg = "already inited";
+        return false;
+    }
+
+    int fd = open( filename.c_str(), O_RDONLY );
+
+    if( fd < 0 )
+    {
+        * error_msg = "cannot open " + filename + ": " + strerror( errno );
+        return false;
+    }
+
+    struct stat st;
+
+    if( fstat( fd, & st ) < 0 )
+    {
+        * error_msg = "cannot stat " + filename + ": " + strerror( errno );
+        close( fd );
+        return false;
+    }
+
+    if( static_cast<uint64_t>( st.st_size ) < start.offset )
+    {
+        * error_msg = "cursor is beyond the end of " + filename;
+        close( fd );
+        return false;
+    }
+
+    if( st.st_size > 0 )
+    {
+        void * p = mmap( nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+
+        if( p == MAP_FAILED )
+        {
+            * error_msg = "cannot mmap " + filename + ": " + strerror( errno );
+            close( fd );
+            return false;
+        }
+
+        madvise( p, st.st_size, MADV_SEQUENTIAL );
+
+        data_   = static_cast<const char*>( p );
+    }
+
+    close( fd );
+
+    size_           = st.st_size;
+
+    // count the entries up front, so that the id range is known before the first call
+
+    uint64_t num_entries    = start.num_read;
+    uint64_t offset         = start.offset;
+
+    const char * begin;
+    const char * end;
+
+    while( find_entry( & offset, & begin, & end ) )
+        num_entries++;
+
+    // ids from first_req_id up to UINT32_MAX inclusive are usable
+    if( num_entries > UINT32_MAX || first_req_id + num_entries > UINT32_MAX + 1ULL )
+    {
+        * error_msg = "req_id range of " + std::to_string( num_entries ) + " entries starting at " + std::to_string( first_req_id ) + " overflows";
+
+        if( data_ != nullptr )
+            munmap( const_cast<char*>( data_ ), size_ );
+
+        data_   = nullptr;
+        size_   = 0;
+
+        return false;
+    }
+
+    first_req_id_   = first_req_id;
+    num_entries_    = num_entries;
+    cursor_         = start;
+
+    return true;
+}
+
+bool MmapDialList::find_entry( uint64_t * offset, const char ** entry_begin, const char ** entry_end ) const
+{
+    // private: no mutex lock
+
+    while( * offset < size_ )
+    {
+        auto begin  = data_ + * offset;
+        auto eol    = static_cast<const char*>( memchr( begin, '\n', size_ - * offset ) );
+        auto end    = eol ? eol : data_ + size_;
+
+        * offset    = ( end - data_ ) + ( eol ? 1 : 0 );
+
+        while( end > begin && ( end[-1] == '\r' || end[-1] == ' ' || end[-1] == '\t' ) )
+            --end;
+
+        while( begin < end && ( * begin == ' ' || * begin == '\t' ) )
+            ++begin;
+
+        if( begin == end || * begin == '#' )
+            continue;
+
+        * entry_begin   = begin;
+        * entry_end     = end;
+
+        return true;
+    }
+
+    return false;
+}
+
+bool MmapDialList::get_next( uint32_t * req_id, std::string * party )
+{
+    MUTEX_SCOPE_LOCK( mutex_ );
+
+    if( is_cancelled_ )
+        return false;
+
+    const char * begin;
+    const char * end;
+
+    if( find_entry( & cursor_.offset, & begin, & end ) == false )
+        return false;
+
+    * req_id    = first_req_id_ + cursor_.num_read;
+
+    party->assign( begin, end );
+
+    cursor_.num_read++;
+
+    return true;
+}
+
+void MmapDialList::get_req_id_range( uint32_t * first_req_id, uint32_t * num_req_ids ) const
+{
+    MUTEX_SCOPE_LOCK( mutex_ );
+
+    * first_req_id  = first_req_id_ + cursor_.num_read;
+    * num_req_ids   = is_cancelled_ ? 0 : num_entries_ - cursor_.num_read;
+}
+
+MmapDialList::Cursor MmapDialList::get_cursor() const
+{
+    MUTEX_SCOPE_LOCK( mutex_ );
+
+    return cursor_;
+}
+
+void MmapDialList::get_progress( uint64_t * bytes_done, uint64_t * bytes_total ) const
+{
+    MUTEX_SCOPE_LOCK( mutex_ );
+
+    * bytes_done    = cursor_.offset;
+    * bytes_total   = size_;
+}
+
+void MmapDialList::cancel()
+{
+    MUTEX_SCOPE_LOCK( mutex_ );
+
+    is_cancelled_   = true;
+}
+
+NAMESPACE_CALMAN_END
@@ -0,0 +1,92 @@
+/*
+
+Memory-mapped dial list.
+
+Copyright (C) 2020 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+// $Revision: 13958 $ $Date:: 2020-10-05 #$ $Author: serge $
+
+#ifndef CALMAN_MMAP_DIAL_LIST_H
+#define CALMAN_MMAP_DIAL_LIST_H
+
+#include <mutex>                            // std::mutex
+
+#include "i_dial_list.h"                    // IDialList
+
+#include "namespace_lib.h"                  // NAMESPACE_CALMAN_START
+
+NAMESPACE_CALMAN_START
+
+// Dial list file: one party per line, empty lines and lines starting with '#' are skipped.
+// The request id of an entry is first_req_id + its number among the entries.
+//
+// The cursor tracks entries handed out to CallManager, not finished calls:
+// resuming from get_cursor() skips the entries whose calls were still in flight,
+// they have to be recovered separately (e.g. from the exported pending requests).
+class MmapDialList: virtual public IDialList
+{
+public:
+
+    struct Cursor
+    {
+        uint64_t    offset;     // offset of the next entry in the file
+        uint32_t    num_read;   // number of entries taken so far, not the number of finished calls
+    };
+
+    MmapDialList();
+    ~MmapDialList();
+
+    bool init(
+            const std::string   & filename,
+            uint32_t            first_req_id,
+            const Cursor        & start,
+            std::string         * error_msg );
+
+    // interface IDialList
+    bool get_next( uint32_t * req_id, std::string * party );
+    void get_req_id_range( uint32_t * first_req_id, uint32_t * num_req_ids ) const;
+
+    // position to resume from after a restart, see the note on in-flight entries above
+    Cursor get_cursor() const;
+
+    void get_progress( uint64_t * bytes_done, uint64_t * bytes_total ) const;
+
+    void cancel();
+
+private:
+
+    // finds the next entry starting at offset, moves offset past it
+    bool find_entry( uint64_t * offset, const char ** begin, const char ** end ) const;
+
+private:
+
+    mutable std::mutex  mutex_;
+
+    const char          * data_;
+    uint64_t            size_;
+
+    uint32_t            first_req_id_;
+    uint32_t            num_entries_;
+    Cursor              cursor_;
+    bool                is_cancelled_;
+};
+
+NAMESPACE_CALMAN_END
+
+#endif  // CALMAN_MMAP_DIAL_LIST_H
@@ -0,0 +1,102 @@
+/*
+
+Pending requests export.
+
+Copyright (C) 2020 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+// $Revision: 13958 $ $Date:: 2020-10-05 #$ $Author: serge $
+
+#include "pending_requests.h"           // self
+
+#include <fstream>                      // std::ofstream
+#include <sstream>                      // std::stringstream
+
+NAMESPACE_CALMAN_START
+
+bool save_pending_requests( const std::string & filename, const PendingRequests & reqs, std::string * error_msg )
+{
+    std::ofstream f( filename );
+
+    if( f.is_open() == false )
+    {
+        * error_msg = "cannot open " + filename;
+        return false;
+    }
+
+    for( auto & r : reqs )
+    {
+        if( r.party.find( '\n' ) != std::string::npos )
+        {
+            * error_msg = "party of request " + std::to_string( r.req_id ) + " contains a line break";
+            return false;
+        }
+
+        f << r.req_id << " " << r.party << "\n";
+    }
+
+    f.close();
+
+    if( f.fail() )
+    {
+        * error_msg = "cannot write " + filename;
+        return false;
+    }
+
+    return true;
+}
+
+bool load_pending_requests( PendingRequests * res, const std::string & filename, std::string * error_msg )
+{
+    std::ifstream f( filename );
+
+    if( f.is_open() == false )
+    {
+        * error_msg = "cannot open " + filename;
+        return false;
+    }
+
+    std::string line;
+    uint32_t    line_num    = 0;
+
+    while( std::getline( f, line ) )
+    {
+        line_num++;
+
+        if( line.empty() )
+            continue;
+
+        std::stringstream stream( line );
+
+        PendingRequest r;
+
+        // the party is the rest of the line after the separating space, it may contain spaces itself
+
+        if( !( stream >> r.req_id ) || stream.get() != ' ' || !std::getline( stream, r.party ) || r.party.empty() )
+        {
+            * error_msg = filename + ":" + std::to_string( line_num ) + ": invalid line";
+            return false;
+        }
+
+        res->push_back( r );
+    }
+
+    return true;
+}
+
+NAMESPACE_CALMAN_END
@@ -0,0 +1,50 @@
+/*
+
+Pending requests export.
+
+Copyright (C) 2020 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+// $Revision: 13958 $ $Date:: 2020-10-05 #$ $Author: serge $
+
+#ifndef CALMAN_PENDING_REQUESTS_H
+#define CALMAN_PENDING_REQUESTS_H
+
+#include <cstdint>                  // uint32_t
+#include <string>                   // std::string
+#include <vector>                   // std::vector
+
+#include "namespace_lib.h"          // NAMESPACE_CALMAN_START
+
+NAMESPACE_CALMAN_START
+
+struct PendingRequest
+{
+    uint32_t        req_id;
+    std::string     party;
+};
+
+typedef std::vector<PendingRequest>     PendingRequests;
+
+// file format: one "<req_id> <party>" per line, the party is the rest of the line and may contain spaces
+bool save_pending_requests( const std::string & filename, const PendingRequests & reqs, std::string * error_msg );
+bool load_pending_requests( PendingRequests * res, const std::string & filename, std::string * error_msg );
+
+NAMESPACE_CALMAN_END
+
+#endif  // CALMAN_PENDING_REQUESTS_H
@@ -0,0 +1,947 @@
+/*
+
+Capacity planning simulator.
+
+Copyright (C) 2020 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// $Revision: 13958 $ $Date:: 2020-10-05 #$ $Author: serge $
+
+// Drives CallManager against simple_voip_dummy (voip_config.ini) on a virtual
+// clock. Both of them get VirtualScheduler as their scheduler, so call
+// durations, retry backoffs and the wait estimate of CallManager all run on
+// virtual time and a busy hour takes seconds of wall time.
+//
+// The dummy answers requests on its own thread. After every event the
+// simulator waits until the dummy has processed everything sent to it (see
+// BackendTap::wait_idle) and only then advances the virtual clock.
+
+#include <iostream>         // cout
+#include <iomanip>          // std::setw
+#include <fstream>          // std::ifstream
+#include <sstream>          // stringstream
+#include <vector>           // std::vector
+#include <set>              // std::set
+#include <map>              // std::map
+#include <random>           // std::mt19937
+#include <functional>       // std::bind
+#include <mutex>            // std::mutex
+#include <condition_variable>   // std::condition_variable
+#include <chrono>           // std::chrono::steady_clock
+
+#include "../call_manager.h"                    // calman::CallManager
+#include "../i_clock.h"                         // calman::IClock
+#include "simple_voip/objects.h"
+#include "simple_voip/object_factory.h"         // simple_voip::create_initiate_call_request
+#include "simple_voip/i_simple_voip.h"          // simple_voip::ISimpleVoip
+#include "simple_voip/i_simple_voip_callback.h" // simple_voip::ISimpleVoipCallback
+#include "scheduler/i_scheduler.h"              // scheduler::IScheduler
+#include "scheduler/onetime_job_aux.h"          // scheduler::create_and_insert_one_time_job
+
+#include "simple_voip_dummy/dummy.h"            // simple_voip_dummy::Dummy
+#include "simple_voip_dummy/init_config.h"      // simple_voip_dummy::init_config
+
+#include "utils/dummy_logger.h"              // dummy_log_set_log_level
+
+typedef uint64_t    VTime;  // virtual time, ms
+
+struct PartyClass
+{
+    std::string     name;
+    uint32_t        weight;
+};
+
+struct RatePoint
+{
+    VTime           from;               // ms
+    double          rate;               // calls per sec
+};
+
+struct Workload
+{
+    uint32_t                    duration;           // sec
+    uint32_t                    report_interval;    // sec
+    std::vector<RatePoint>      rates;
+    std::vector<PartyClass>     parties;
+    std::vector<uint32_t>       limits;
+    uint32_t                    seed;
+
+    uint32_t                    max_attempts;
+    uint32_t                    retry_delay_min;    // ms
+    uint32_t                    retry_delay_max;    // ms
+    std::set<uint32_t>          retry_reject_codes;
+    std::set<uint32_t>          retry_error_codes;
+    uint32_t                    max_estimated_wait; // ms
+};
+
+bool read_codes( std::set<uint32_t> * res, std::stringstream & stream )
+{
+    uint32_t code;
+
+    while( stream >> code )
+        res->insert( code );
+
+    return stream.eof();
+}
+
+bool load_workload( Workload * res, const std::string & filename, std::string * error_msg )
+{
+    std::ifstream f( filename );
+
+    if( f.is_open() == false )
+    {
+        * error_msg = "cannot open " + filename;
+        return false;
+    }
+
+    res->duration           = 3600;
+    res->report_interval    = 300;
+    res->seed               = 1;
+
+    res->max_attempts       = 1;
+    res->retry_delay_min    = 1000;
+    res->retry_delay_max    = 60000;
+    res->max_estimated_wait = 0;
+
+    std::string line;
+    uint32_t    line_num    = 0;
+
+    while( std::getline( f, line ) )
+    {
+        line_num++;
+
+        auto pos = line.find( '#' );
+        if( pos != std::string::npos )
+            line.erase( pos );
+
+        std::stringstream stream( line );
+
+        std::string cmd;
+
+        if( !( stream >> cmd ) )
+            continue;
+
+        bool b = false;
+
+        if( cmd == "duration" )
+        {
+            b = !!( stream >> res->duration );
+        }
+        else if( cmd == "report_interval" )
+        {
+            b = !!( stream >> res->report_interval ) && res->report_interval > 0;
+        }
+        else if( cmd == "seed" )
+        {
+            b = !!( stream >> res->seed );
+        }
+        else if( cmd == "arrival_rate" )
+        {
+            double from;
+            RatePoint p;
+
+            b = !!( stream >> from >> p.rate ) && from >= 0 && p.rate >= 0
+                    && ( res->rates.empty() || from * 1000 > res->rates.back().from );
+
+            p.from  = static_cast<VTime>( from * 1000 );
+
+            res->rates.push_back( p );
+        }
+        else if( cmd == "party" )
+        {
+            PartyClass p = { std::string(), 0 };
+
+            b = !!( stream >> p.name >> p.weight ) && p.weight > 0;
+
+            res->parties.push_back( p );
+        }
+        else if( cmd == "max_active_calls" )
+        {
+            uint32_t l;
+
+            while( stream >> l )
+            {
+                if( l < 1 )
+                    break;
+
+                res->limits.push_back( l );
+
+                b = true;
+            }
+        }
+        else if( cmd == "max_attempts" )
+        {
+            b = !!( stream >> res->max_attempts ) && res->max_attempts > 0;
+        }
+        else if( cmd == "retry_delay" )
+        {
+            b = !!( stream >> res->retry_delay_min >> res->retry_delay_max ) && res->retry_delay_min <= res->retry_delay_max;
+        }
+        else if( cmd == "retry_reject_codes" )
+        {
+            b = read_codes( & res->retry_reject_codes, stream );
+        }
+        else if( cmd == "retry_error_codes" )
+        {
+            b = read_codes( & res->retry_error_codes, stream );
+        }
+        else if( cmd == "max_estimated_wait" )
+        {
+            b = !!( stream >> res->max_estimated_wait );
+        }
+
+        if( b == false )
+        {
+            * error_msg = filename + ":" + std::to_string( line_num ) + ": invalid line '" + line + "'";
+            return false;
+        }
+    }
+
+    if( res->rates.empty() || res->parties.empty() || res->limits.empty() )
+    {
+        * error_msg = "workload must define arrival_rate, party and max_active_calls";
+        return false;
+    }
+
+    return true;
+}
+
+// Scheduler with a virtual clock that starts at the epoch and only moves in run_next().
+//
+// The dummy computes execution times from the wall clock, CallManager and the
+// simulator from get_now(). Since the virtual clock stays decades away from the
+// wall clock, an execution time within a day of the wall clock is taken as
+// a delay relative to the wall clock and moved to the virtual one.
+class VirtualScheduler: virtual public scheduler::IScheduler, virtual public calman::IClock
+{
+public:
+    VirtualScheduler():
+        last_job_id_( 0 )
+    {
+    }
+
+    ~VirtualScheduler()
+    {
+        // jobs never executed, e.g. ends of the calls still active when the run is over
+        for( auto & e : map_id_to_job_ )
+            delete e.second;
+    }
+
+    // interface IClock
+    scheduler::Time get_now() const
+    {
+        std::lock_guard<std::mutex> lock( mutex_ );
+
+        return now_;
+    }
+
+    // interface IScheduler
+    bool insert_job( scheduler::job_id_t * job_id, scheduler::IJob * job, std::string * error_msg )
+    {
+        std::lock_guard<std::mutex> lock( mutex_ );
+
+        auto exec_time  = job->get_exec_time();
+        auto wall_now   = std::chrono::system_clock::now();
+
+        if( exec_time > wall_now - std::chrono::hours( 24 ) && exec_time < wall_now + std::chrono::hours( 24 ) )
+        {
+            exec_time = now_ + std::max( exec_time - wall_now, scheduler::Time::duration::zero() );
+        }
+
+        * job_id = ++last_job_id_;
+
+        map_id_to_job_[ * job_id ]  = job;
+
+        queue_.insert( std::make_pair( exec_time, * job_id ) );
+
+        return true;
+    }
+
+    bool delete_job( scheduler::job_id_t job_id, std::string * error_msg )
+    {
+        std::lock_guard<std::mutex> lock( mutex_ );
+
+        auto it = map_id_to_job_.find( job_id );
+
+        if( it == map_id_to_job_.end() )
+        {
+            * error_msg = "job " + std::to_string( job_id ) + " not found";
+            return false;
+        }
+
+        for( auto q = queue_.begin(); q != queue_.end(); ++q )
+        {
+            if( q->second == job_id )
+            {
+                queue_.erase( q );
+                break;
+            }
+        }
+
+        delete it->second;
+
+        map_id_to_job_.erase( it );
+
+        return true;
+    }
+
+    // executes the earliest job if it is due not later than 'until'
+    bool run_next( const scheduler::Time & until )
+    {
+        scheduler::IJob * job;
+
+        {
+            std::lock_guard<std::mutex> lock( mutex_ );
+
+            if( queue_.empty() || queue_.begin()->first > until )
+            {
+                now_ = std::max( now_, until );
+                return false;
+            }
+
+            auto job_id = queue_.begin()->second;
+
+            now_    = queue_.begin()->first;
+
+            queue_.erase( queue_.begin() );
+
+            auto it = map_id_to_job_.find( job_id );
+
+            job = it->second;
+
+            map_id_to_job_.erase( it );
+        }
+
+        job->invoke();
+
+        delete job;
+
+        return true;
+    }
+
+private:
+
+    // time and id, equal times are executed in the order of insertion
+    typedef std::set<std::pair<scheduler::Time, scheduler::job_id_t>>   Queue;
+
+private:
+    mutable std::mutex      mutex_;
+
+    scheduler::Time         now_;
+    scheduler::job_id_t     last_job_id_;
+
+    Queue                   queue_;
+    std::map<scheduler::job_id_t, scheduler::IJob*> map_id_to_job_;
+};
+
+class Stats
+{
+public:
+    Stats( const calman::IClock * clock, const Workload & wl ):
+        clock_( clock ),
+        interval_( wl.report_interval * 1000 ),
+        buckets_( ( wl.duration + wl.report_interval - 1 ) / wl.report_interval ),
+        busy_slots_( 0 ),
+        last_( 0 ),
+        num_completed_( 0 )
+    {
+    }
+
+    void on_arrival( uint32_t req_id )
+    {
+        std::lock_guard<std::mutex> lock( mutex_ );
+
+        arrival_time_[ req_id ] = now();
+
+        if( auto * b = bucket() )
+            b->arrived++;
+    }
+
+    void on_dispatch( uint32_t req_id )
+    {
+        std::lock_guard<std::mutex> lock( mutex_ );
+
+        advance();
+
+        busy_slots_++;
+
+        auto it = arrival_time_.find( req_id );
+
+        if( it == arrival_time_.end() )
+        {
+            if( auto * b = bucket() )
+                b->retried++;
+
+            return;
+        }
+
+        auto wait = now() - it->second;
+
+        arrival_time_.erase( it );
+
+        if( auto * b = bucket() )
+        {
+            b->dispatched++;
+            b->wait_sum     += wait;
+            b->wait_max     = std::max( b->wait_max, wait );
+        }
+    }
+
+    // the backend frees the slot
+    void on_release( bool is_connected )
+    {
+        std::lock_guard<std::mutex> lock( mutex_ );
+
+        advance();
+
+        busy_slots_--;
+
+        num_completed_++;
+
+        if( auto * b = bucket() )
+        {
+            b->completed++;
+
+            if( is_connected )
+                b->connected++;
+        }
+    }
+
+    // the client gets the final RejectResponse or ErrorResponse
+    void on_rejected( uint32_t req_id )
+    {
+        std::lock_guard<std::mutex> lock( mutex_ );
+
+        auto * b = bucket();
+
+        if( arrival_time_.erase( req_id ) > 0 )
+        {
+            if( b )
+                b->shed++;
+        }
+        else if( b )
+        {
+            b->rejected++;
+        }
+    }
+
+    void report( std::ostream & os, uint32_t max_active_calls )
+    {
+        std::lock_guard<std::mutex> lock( mutex_ );
+
+        advance();
+
+        os << "max_active_calls " << max_active_calls << "\n"
+           << "  time_sec  occupancy%  avg_busy  arrived    shed  dispatched  retried  wait_avg_s  wait_max_s  rejected  completed  connected  calls/s\n";
+
+        double interval_sec = interval_ / 1000.0;
+
+        for( size_t i = 0; i < buckets_.size(); ++i )
+        {
+            auto & b = buckets_[i];
+
+            double avg_busy = b.busy_slot_time / double( interval_ );
+
+            os << std::fixed << std::setprecision( 2 )
+               << std::setw( 10 ) << ( i + 1 ) * interval_ / 1000
+               << std::setw( 12 ) << 100.0 * avg_busy / max_active_calls
+               << std::setw( 10 ) << avg_busy
+               << std::setw( 9 )  << b.arrived
+               << std::setw( 8 )  << b.shed
+               << std::setw( 12 ) << b.dispatched
+               << std::setw( 9 )  << b.retried
+               << std::setw( 12 ) << ( b.dispatched ? b.wait_sum / 1000.0 / b.dispatched : 0.0 )
+               << std::setw( 12 ) << b.wait_max / 1000.0
+               << std::setw( 10 ) << b.rejected
+               << std::setw( 11 ) << b.completed
+               << std::setw( 11 ) << b.connected
+               << std::setw( 9 )  << b.completed / interval_sec
+               << "\n";
+        }
+
+        os << "  still queued " << arrival_time_.size() << ", still busy " << busy_slots_ << "\n";
+    }
+
+    uint64_t get_num_completed() const
+    {
+        std::lock_guard<std::mutex> lock( mutex_ );
+
+        return num_completed_;
+    }
+
+private:
+
+    struct Bucket
+    {
+        uint64_t    busy_slot_time; // slot * ms
+        uint32_t    arrived;
+        uint32_t    shed;
+        uint32_t    dispatched;
+        uint32_t    retried;
+        uint64_t    wait_sum;       // ms
+        VTime       wait_max;       // ms
+        uint32_t    rejected;
+        uint32_t    completed;
+        uint32_t    connected;
+    };
+
+    VTime now() const
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>( clock_->get_now().time_since_epoch() ).count();
+    }
+
+    Bucket * bucket()
+    {
+        auto i = now() / interval_;
+
+        return i < buckets_.size() ? & buckets_[i] : nullptr;
+    }
+
+    // integrates busy slots up to the current virtual time
+    void advance()
+    {
+        auto now = this->now();
+
+        while( last_ < now )
+        {
+            auto i = last_ / interval_;
+
+            if( i >= buckets_.size() )
+                break;
+
+            auto end = std::min( now, ( i + 1 ) * interval_ );
+
+            buckets_[i].busy_slot_time += busy_slots_ * ( end - last_ );
+
+            last_ = end;
+        }
+
+        last_ = now;
+    }
+
+private:
+    mutable std::mutex          mutex_;
+
+    const calman::IClock        * clock_;
+    VTime                       interval_;
+
+    std::vector<Bucket>         buckets_;
+    std::map<uint32_t, VTime>   arrival_time_;
+
+    uint32_t                    busy_slots_;
+    VTime                       last_;
+    uint64_t                    num_completed_;
+};
+
+// Sits between CallManager and the dummy, counts backend slots for Stats and
+// tells when the dummy has nothing left to process.
+class BackendTap: virtual public simple_voip::ISimpleVoip, virtual public simple_voip::ISimpleVoipCallback
+{
+public:
+    BackendTap( Stats * stats ):
+        stats_( stats ),
+        backend_( nullptr ),
+        calman_( nullptr ),
+        num_forwarded_( 0 ),
+        barrier_req_id_( 0 ),
+        is_barrier_answered_( false )
+    {
+    }
+
+    void init( simple_voip::ISimpleVoip * backend, simple_voip::ISimpleVoipCallback * calman )
+    {
+        backend_    = backend;
+        calman_     = calman;
+    }
+
+    // interface ISimpleVoip
+    void consume( const simple_voip::ForwardObject * obj )
+    {
+        {
+            std::lock_guard<std::mutex> lock( mutex_ );
+
+            num_forwarded_++;
+
+            if( dynamic_cast< const simple_voip::InitiateCallRequest *>( obj ) )
+            {
+                initiating_req_ids_.insert( obj->req_id );
+
+                stats_->on_dispatch( obj->req_id );
+            }
+        }
+
+        backend_->consume( obj );
+    }
+
+    // interface ISimpleVoipCallback
+    void consume( const simple_voip::CallbackObject * obj )
+    {
+        if( handle_barrier( obj ) )
+            return;
+
+        update_stats( obj );
+
+        calman_->consume( obj );
+    }
+
+    // Waits until the dummy has processed every request and event sent to it.
+    // The dummy handles them one by one in a single worker, so when the answer
+    // to a DropRequest for a non-existing call arrives, everything sent before
+    // has been processed. Answers may make CallManager send new requests, so
+    // repeat until a round passes without them.
+    bool wait_idle( std::string * error_msg )
+    {
+        std::unique_lock<std::mutex> lock( mutex_ );
+
+        do
+        {
+            num_forwarded_          = 0;
+            is_barrier_answered_    = false;
+
+            auto req_id = --barrier_req_id_;
+
+            lock.unlock();
+
+            backend_->consume( simple_voip::create_drop_request( req_id, 0 ) );
+
+            lock.lock();
+
+            if( cond_.wait_for( lock, std::chrono::seconds( 1 ), [this]() { return is_barrier_answered_; } ) == false )
+            {
+                * error_msg = "backend did not answer DropRequest " + std::to_string( req_id );
+                return false;
+            }
+        }
+        while( num_forwarded_ > 0 );
+
+        return true;
+    }
+
+private:
+
+    bool handle_barrier( const simple_voip::CallbackObject * obj )
+    {
+        auto * resp = dynamic_cast< const simple_voip::ResponseObject *>( obj );
+
+        if( resp == nullptr )
+            return false;
+
+        std::lock_guard<std::mutex> lock( mutex_ );
+
+        if( resp->req_id != barrier_req_id_ )
+            return false;
+
+        delete obj;
+
+        is_barrier_answered_ = true;
+
+        cond_.notify_one();
+
+        return true;
+    }
+
+    void update_stats( const simple_voip::CallbackObject * obj )
+    {
+        std::lock_guard<std::mutex> lock( mutex_ );
+
+        if( auto * r = dynamic_cast< const simple_voip::InitiateCallResponse *>( obj ) )
+        {
+            if( initiating_req_ids_.erase( r->req_id ) > 0 )
+                active_call_ids_.insert( r->call_id );
+        }
+        else if( dynamic_cast< const simple_voip::RejectResponse *>( obj ) || dynamic_cast< const simple_voip::ErrorResponse *>( obj ) )
+        {
+            auto * r = static_cast< const simple_voip::ResponseObject *>( obj );
+
+            if( initiating_req_ids_.erase( r->req_id ) > 0 )
+                stats_->on_release( false );
+        }
+        else if( auto * e = dynamic_cast< const simple_voip::ConnectionLost *>( obj ) )
+        {
+            if( active_call_ids_.erase( e->call_id ) > 0 )
+                stats_->on_release( true );
+        }
+        else if( auto * e = dynamic_cast< const simple_voip::Failed *>( obj ) )
+        {
+            if( active_call_ids_.erase( e->call_id ) > 0 )
+                stats_->on_release( false );
+        }
+    }
+
+private:
+    mutable std::mutex                  mutex_;
+    std::condition_variable             cond_;
+
+    Stats                               * stats_;
+    simple_voip::ISimpleVoip            * backend_;
+    simple_voip::ISimpleVoipCallback    * calman_;
+
+    std::set<uint32_t>                  initiating_req_ids_;
+    std::set<uint32_t>                  active_call_ids_;
+
+    uint32_t                            num_forwarded_;     // since the last barrier
+    uint32_t                            barrier_req_id_;    // counts down from UINT32_MAX, arrivals count up
+    bool                                is_barrier_answered_;
+};
+
+class Sink: virtual public simple_voip::ISimpleVoipCallback
+{
+public:
+    Sink( Stats * stats ):
+        stats_( stats )
+    {
+    }
+
+    // interface ISimpleVoipCallback
+    void consume( const simple_voip::CallbackObject * obj )
+    {
+        if( dynamic_cast< const simple_voip::RejectResponse *>( obj ) || dynamic_cast< const simple_voip::ErrorResponse *>( obj ) )
+        {
+            stats_->on_rejected( static_cast< const simple_voip::ResponseObject *>( obj )->req_id );
+        }
+
+        delete obj;
+    }
+
+private:
+    Stats                               * stats_;
+};
+
+class ArrivalGenerator
+{
+public:
+    ArrivalGenerator( scheduler::IScheduler * sched, Stats * stats, simple_voip::ISimpleVoip * calman, const Workload & wl, uint32_t seed ):
+        sched_( sched ),
+        stats_( stats ),
+        calman_( calman ),
+        wl_( wl ),
+        rng_( seed ),
+        last_req_id_( 0 )
+    {
+        std::vector<uint32_t> weights;
+
+        for( auto & p : wl_.parties )
+            weights.push_back( p.weight );
+
+        party_dist_ = std::discrete_distribution<size_t>( weights.begin(), weights.end() );
+    }
+
+    bool start( std::string * error_msg )
+    {
+        return schedule_next( 0, error_msg );
+    }
+
+private:
+
+    double get_rate( VTime t, VTime * next_change ) const
+    {
+        double rate = 0;
+
+        * next_change = wl_.duration * 1000ULL;
+
+        for( auto & p : wl_.rates )
+        {
+            if( p.from > t )
+            {
+                * next_change = std::min( * next_change, p.from );
+                break;
+            }
+
+            rate = p.rate;
+        }
+
+        return rate;
+    }
+
+    // Poisson arrivals with piecewise constant rate: when the sampled gap crosses
+    // a rate change, restart sampling at the change point (memorylessness)
+    bool schedule_next( VTime t, std::string * error_msg )
+    {
+        VTime end = wl_.duration * 1000ULL;
+
+        while( t < end )
+        {
+            VTime next_change;
+
+            double rate = get_rate( t, & next_change );
+
+            if( rate > 0 )
+            {
+                auto gap = static_cast<VTime>( std::exponential_distribution<double>( rate )( rng_ ) * 1000 );
+
+                if( t + gap < next_change )
+                {
+                    auto arrival = t + gap;
+
+                    scheduler::job_id_t job_id;
+
+                    return scheduler::create_and_insert_one_time_job(
+                            & job_id, "arrival", sched_, scheduler::Time( std::chrono::milliseconds( arrival ) ),
+                            std::bind( & ArrivalGenerator::on_arrival, this, arrival ), error_msg );
+                }
+            }
+
+            t = next_change;
+        }
+
+        return true;
+    }
+
+    void on_arrival( VTime t )
+    {
+        auto req_id = ++last_req_id_;
+
+        stats_->on_arrival( req_id );
+
+        calman_->consume( simple_voip::create_initiate_call_request( req_id, wl_.parties[ party_dist_( rng_ ) ].name ) );
+
+        std::string error_msg;
+
+        if( schedule_next( t, & error_msg ) == false )
+        {
+            std::cerr << "ERROR: cannot schedule the next arrival: " << error_msg << std::endl;
+        }
+    }
+
+private:
+    scheduler::IScheduler           * sched_;
+    Stats                           * stats_;
+    simple_voip::ISimpleVoip        * calman_;
+    const Workload                  & wl_;
+
+    std::mt19937                    rng_;
+    std::discrete_distribution<size_t>  party_dist_;
+    uint32_t                        last_req_id_;
+};
+
+bool run_simulation( const Workload & wl, const simple_voip_dummy::Config & voip_cfg, uint32_t max_active_calls,
+        unsigned int log_id, unsigned int log_id_dummy, std::string * error_msg )
+{
+    // declared in the order of dependence, so each one outlives its users
+    VirtualScheduler            sched;
+    Stats                       stats( & sched, wl );
+    Sink                        sink( & stats );
+    calman::CallManager         calman;
+    BackendTap                  tap( & stats );
+    simple_voip_dummy::Dummy    dummy;
+
+    calman::Config      cfg;
+
+    cfg.max_active_calls    = max_active_calls;
+    cfg.max_attempts        = wl.max_attempts;
+    cfg.retry_delay_min     = wl.retry_delay_min;
+    cfg.retry_delay_max     = wl.retry_delay_max;
+    cfg.retry_reject_codes  = wl.retry_reject_codes;
+    cfg.retry_error_codes   = wl.retry_error_codes;
+    cfg.max_estimated_wait  = wl.max_estimated_wait;
+    cfg.drain_policy        = calman::drain_policy_e::REJECT;
+    cfg.drain_timeout       = 0;
+
+    if( calman.init( log_id, & tap, & sink, & sched, cfg, error_msg ) == false )
+        return false;
+
+    if( dummy.init( log_id_dummy, log_id_dummy, voip_cfg, & tap, & sched, error_msg ) == false )
+        return false;
+
+    tap.init( & dummy, & calman );
+
+    ArrivalGenerator    gen( & sched, & stats, & calman, wl, wl.seed + 1 );
+
+    if( gen.start( error_msg ) == false )
+        return false;
+
+    dummy.start();
+
+    auto wall_start = std::chrono::steady_clock::now();
+
+    auto end = scheduler::Time( std::chrono::seconds( wl.duration ) );
+
+    bool b = true;
+
+    while( b && sched.run_next( end ) )
+    {
+        b = tap.wait_idle( error_msg );
+    }
+
+    auto wall_ms = std::chrono::duration_cast<std::chrono::milliseconds>( std::chrono::steady_clock::now() - wall_start ).count();
+
+    if( b )
+    {
+        stats.report( std::cout, max_active_calls );
+
+        std::cout << "  simulated " << stats.get_num_completed() << " calls in " << wall_ms << " ms of wall time\n" << std::endl;
+    }
+
+    // queued requests and retries are rejected and deleted, calls still active in the dummy
+    // are deleted by its shutdown, their jobs by the destructor of the scheduler
+    calman.drain( calman::drain_policy_e::REJECT, 0, nullptr );
+
+    dummy.shutdown();
+
+    return b;
+}
+
+int main( int argc, char **argv )
+{
+    if( argc < 2 )
+    {
+        std::cerr << "USAGE: simulator <workload_script> [<voip_config.ini>]" << std::endl;
+
+        return EXIT_FAILURE;
+    }
+
+    std::string error_msg;
+
+    Workload wl;
+
+    if( load_workload( & wl, argv[1], & error_msg ) == false )
+    {
+        std::cerr << "ERROR: " << error_msg << std::endl;
+
+        return EXIT_FAILURE;
+    }
+
+    std::string config_file( argc > 2 ? argv[2] : "../voip_config.ini" );
+
+    config_reader::ConfigReader cr;
+
+    cr.init( config_file );
+
+    simple_voip_dummy::Config voip_cfg;
+
+    simple_voip_dummy::init_config( & voip_cfg, cr );
+
+    dummy_logger::set_log_level( log_levels_log4j::ERROR );
+
+    auto log_id_calman      = dummy_logger::register_module( "CallManager" );
+    auto log_id_dummy       = dummy_logger::register_module( "SimpleVoipDummy" );
+
+    dummy_logger::set_log_level( log_id_calman,     log_levels_log4j::ERROR );
+    dummy_logger::set_log_level( log_id_dummy,      log_levels_log4j::ERROR );
+
+    for( auto l : wl.limits )
+    {
+        if( run_simulation( wl, voip_cfg, l, log_id_calman, log_id_dummy, & error_msg ) == false )
+        {
+            std::cerr << "ERROR: " << error_msg << std::endl;
+
+            return EXIT_FAILURE;
+        }
+    }
+
+    return 0;
+}
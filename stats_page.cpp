@@ -0,0 +1,172 @@
+/*
+
+Shared memory stats page.
+
+Copyright (C) 2020 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+// $Revision: 13958 $ $Date:: 2020-10-05 #$ $Author: serge $
+
+#include "stats_page.h"                 // self
+
+#include <new>                          // placement new
+#include <cstring>                      // strerror
+#include <cerrno>                       // errno
+#include <fcntl.h>                      // O_CREAT
+#include <unistd.h>                     // ftruncate, getpid
+#include <signal.h>                     // kill
+#include <sys/mman.h>                   // shm_open, mmap
+#include <sys/stat.h>                   // fstat
+
+NAMESPACE_CALMAN_START
+
+StatsPublisher::StatsPublisher():
+    page_( nullptr )
+{
+}
+
+StatsPublisher::~StatsPublisher()
+{
+    if( page_ == nullptr )
+        return;
+
+    munmap( page_, sizeof( StatsPage ) );
+
+    shm_unlink( name_.c_str() );
+}
+
+bool StatsPublisher::init( const std::string & name, std::string * error_msg )
+{
+    if( page_ != nullptr )
+    {
+        * error_msg = "already inited";
+        return false;
+    }
+
+    int fd = shm_open( name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644 );
+
+    if( fd < 0 && errno == EEXIST && is_stale( name ) )
+    {
+        shm_unlink( name.c_str() );
+
+        fd = shm_open( name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644 );
+    }
+
+    if( fd < 0 )
+    {
+        if( errno == EEXIST )
+            * error_msg = "shared memory " + name + " is used by another instance";
+        else
+            * error_msg = "cannot create shared memory " + name + ": " + strerror( errno );
+
+        return false;
+    }
+
+    if( ftruncate( fd, sizeof( StatsPage ) ) < 0 )
+    {
+        * error_msg = "cannot resize shared memory " + name + ": " + strerror( errno );
+        close( fd );
+        return false;
+    }
+
+    void * p = mmap( nullptr, sizeof( StatsPage ), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+
+    close( fd );
+
+    if( p == MAP_FAILED )
+    {
+        * error_msg = "cannot map shared memory " + name + ": " + strerror( errno );
+        return false;
+    }
+
+    page_   = new( p ) StatsPage();
+
+    page_->magic    = StatsPage::MAGIC;
+    page_->version  = StatsPage::VERSION;
+    page_->pid      = getpid();
+
+    name_   = name;
+
+    return true;
+}
+
+bool StatsPublisher::is_stale( const std::string & name )
+{
+    std::string error_msg;
+
+    auto * page = open_stats_page( name, & error_msg );
+
+    // a segment that cannot be read may be being created right now, it is left alone
+    if( page == nullptr )
+        return false;
+
+    bool res = kill( page->pid, 0 ) < 0 && errno == ESRCH;
+
+    close_stats_page( page );
+
+    return res;
+}
+
+const StatsPage * open_stats_page( const std::string & name, std::string * error_msg )
+{
+    int fd = shm_open( name.c_str(), O_RDONLY, 0 );
+
+    if( fd < 0 )
+    {
+        * error_msg = "cannot open shared memory " + name + ": " + strerror( errno );
+        return nullptr;
+    }
+
+    struct stat st;
+
+    // the segment is empty until its owner has resized it, mapping it then would fault on access
+    if( fstat( fd, & st ) < 0 || static_cast<size_t>( st.st_size ) < sizeof( StatsPage ) )
+    {
+        * error_msg = "shared memory " + name + " is not initialized";
+        close( fd );
+        return nullptr;
+    }
+
+    void * p = mmap( nullptr, sizeof( StatsPage ), PROT_READ, MAP_SHARED, fd, 0 );
+
+    close( fd );
+
+    if( p == MAP_FAILED )
+    {
+        * error_msg = "cannot map shared memory " + name + ": " + strerror( errno );
+        return nullptr;
+    }
+
+    auto * page = static_cast<const StatsPage*>( p );
+
+    if( page->magic != StatsPage::MAGIC || page->version != StatsPage::VERSION )
+    {
+        * error_msg = "unexpected format of shared memory " + name;
+        close_stats_page( page );
+        return nullptr;
+    }
+
+    return page;
+}
+
+void close_stats_page( const StatsPage * page )
+{
+    munmap( const_cast<StatsPage*>( page ), sizeof( StatsPage ) );
+}
+
+NAMESPACE_CALMAN_END
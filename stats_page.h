@@ -0,0 +1,171 @@
+/*
+
+Shared memory stats page.
+
+Copyright (C) 2020 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+// $Revision: 13958 $ $Date:: 2020-10-05 #$ $Author: serge $
+
+#ifndef CALMAN_STATS_PAGE_H
+#define CALMAN_STATS_PAGE_H
+
+#include <atomic>                   // std::atomic
+#include <cstdint>                  // uint32_t
+#include <string>                   // std::string
+
+#include "namespace_lib.h"          // NAMESPACE_CALMAN_START
+
+NAMESPACE_CALMAN_START
+
+static_assert( ATOMIC_INT_LOCK_FREE == 2 && ATOMIC_LLONG_LOCK_FREE == 2, "stats page needs lock-free atomics" );
+
+struct CallStats
+{
+    uint32_t    max_active_calls;
+    uint32_t    active_calls;
+    uint32_t    active_requests;
+    uint32_t    pending_requests;
+    uint32_t    waiting_retries;
+
+    // monotonic counters, rates are derived by the reader
+    uint64_t    num_dispatched;     // requests sent to the backend
+    uint64_t    num_established;    // calls established
+    uint64_t    num_failed;         // failed requests reported to the client
+    uint64_t    num_retries;
+    uint64_t    num_retries_exhausted;  // requests failed after the last attempt
+    uint64_t    total_retry_delay;      // ms, sum of the backoffs of all retries
+};
+
+// Page in shared memory, updated under a seqlock: the single writer makes
+// the sequence odd while it stores the values, readers retry if they saw
+// an odd or a changed sequence. Neither side ever blocks.
+struct StatsPage
+{
+    static const uint32_t   MAGIC   = 0x4D4C4143;   // "CALM"
+    static const uint32_t   VERSION = 2;
+
+    uint32_t                magic;
+    uint32_t                version;
+    uint32_t                pid;
+
+    std::atomic<uint32_t>   seq;
+
+    std::atomic<uint32_t>   max_active_calls;
+    std::atomic<uint32_t>   active_calls;
+    std::atomic<uint32_t>   active_requests;
+    std::atomic<uint32_t>   pending_requests;
+    std::atomic<uint32_t>   waiting_retries;
+
+    std::atomic<uint64_t>   num_dispatched;
+    std::atomic<uint64_t>   num_established;
+    std::atomic<uint64_t>   num_failed;
+    std::atomic<uint64_t>   num_retries;
+    std::atomic<uint64_t>   num_retries_exhausted;
+    std::atomic<uint64_t>   total_retry_delay;
+
+    void write( const CallStats & s )
+    {
+        auto n = seq.load( std::memory_order_relaxed );
+
+        seq.store( n + 1, std::memory_order_relaxed );
+        std::atomic_thread_fence( std::memory_order_release );
+
+        max_active_calls.store( s.max_active_calls, std::memory_order_relaxed );
+        active_calls.store( s.active_calls, std::memory_order_relaxed );
+        active_requests.store( s.active_requests, std::memory_order_relaxed );
+        pending_requests.store( s.pending_requests, std::memory_order_relaxed );
+        waiting_retries.store( s.waiting_retries, std::memory_order_relaxed );
+        num_dispatched.store( s.num_dispatched, std::memory_order_relaxed );
+        num_established.store( s.num_established, std::memory_order_relaxed );
+        num_failed.store( s.num_failed, std::memory_order_relaxed );
+        num_retries.store( s.num_retries, std::memory_order_relaxed );
+        num_retries_exhausted.store( s.num_retries_exhausted, std::memory_order_relaxed );
+        total_retry_delay.store( s.total_retry_delay, std::memory_order_relaxed );
+
+        seq.store( n + 2, std::memory_order_release );
+    }
+
+    // returns false if no consistent snapshot was taken within max_tries
+    bool read( CallStats * res, uint32_t max_tries = 1000 ) const
+    {
+        for( uint32_t i = 0; i < max_tries; ++i )
+        {
+            auto n = seq.load( std::memory_order_acquire );
+
+            if( n & 1 )
+                continue;
+
+            res->max_active_calls      = max_active_calls.load( std::memory_order_relaxed );
+            res->active_calls          = active_calls.load( std::memory_order_relaxed );
+            res->active_requests       = active_requests.load( std::memory_order_relaxed );
+            res->pending_requests      = pending_requests.load( std::memory_order_relaxed );
+            res->waiting_retries       = waiting_retries.load( std::memory_order_relaxed );
+            res->num_dispatched        = num_dispatched.load( std::memory_order_relaxed );
+            res->num_established       = num_established.load( std::memory_order_relaxed );
+            res->num_failed            = num_failed.load( std::memory_order_relaxed );
+            res->num_retries           = num_retries.load( std::memory_order_relaxed );
+            res->num_retries_exhausted = num_retries_exhausted.load( std::memory_order_relaxed );
+            res->total_retry_delay     = total_retry_delay.load( std::memory_order_relaxed );
+
+            std::atomic_thread_fence( std::memory_order_acquire );
+
+            if( seq.load( std::memory_order_relaxed ) == n )
+                return true;
+        }
+
+        return false;
+    }
+};
+
+// Creates the shared memory segment and owns it, the segment is removed in the destructor.
+// init() fails if the segment exists and its owner is alive, so every instance needs its own
+// name; a segment left behind by a dead process is replaced.
+class StatsPublisher
+{
+public:
+    StatsPublisher();
+    ~StatsPublisher();
+
+    bool init( const std::string & name, std::string * error_msg );
+
+    // no-op if not inited
+    void publish( const CallStats & s )
+    {
+        if( page_ )
+            page_->write( s );
+    }
+
+private:
+
+    // the owner of the segment is gone
+    static bool is_stale( const std::string & name );
+
+private:
+    std::string     name_;
+    StatsPage       * page_;
+};
+
+// Maps an existing segment read-only, returns nullptr on failure.
+const StatsPage * open_stats_page( const std::string & name, std::string * error_msg );
+
+void close_stats_page( const StatsPage * page );
+
+NAMESPACE_CALMAN_END
+
+#endif  // CALMAN_STATS_PAGE_H
@@ -0,0 +1,104 @@
+/*
+
+Reader of the shared memory stats page.
+
+Copyright (C) 2020 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// $Revision: 13958 $ $Date:: 2020-10-05 #$ $Author: serge $
+
+#include <iostream>         // cout
+#include <iomanip>          // std::setw
+#include <thread>           // std::this_thread::sleep_for
+#include <chrono>           // std::chrono::steady_clock
+
+#include "../stats_page.h"  // calman::open_stats_page
+
+int main( int argc, char **argv )
+{
+    std::string name( argc > 1 ? argv[1] : "/calman_stats" );
+
+    unsigned interval_ms = argc > 2 ? std::stoi( argv[2] ) : 1000;
+
+    std::string error_msg;
+
+    auto * page = calman::open_stats_page( name, & error_msg );
+
+    if( page == nullptr )
+    {
+        std::cerr << "ERROR: " << error_msg << std::endl;
+
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "pid " << page->pid << ", interval " << interval_ms << " ms (0 - print once)" << std::endl;
+
+    std::cout << " limit  calls   reqs  pending  retrying  dispatched/s  established/s  failed/s  retries/s  exhausted/s  retry_delay_ms" << std::endl;
+
+    calman::CallStats prev  = {};
+    auto prev_time          = std::chrono::steady_clock::now();
+    bool has_prev           = false;
+
+    while( true )
+    {
+        calman::CallStats s;
+
+        auto now = std::chrono::steady_clock::now();
+
+        if( page->read( & s ) == false )
+        {
+            std::cerr << "WARNING: cannot take a consistent snapshot" << std::endl;
+        }
+        else
+        {
+            double sec = std::chrono::duration<double>( now - prev_time ).count();
+
+            auto rate = [&]( uint64_t cur, uint64_t old ) { return has_prev && sec > 0 ? ( cur - old ) / sec : 0.0; };
+
+            // mean backoff of the retries scheduled in the interval, of all retries on the first line
+            auto retries    = s.num_retries - prev.num_retries;
+            auto delay      = s.total_retry_delay - prev.total_retry_delay;
+
+            std::cout << std::fixed << std::setprecision( 1 )
+                      << std::setw( 6 )  << s.max_active_calls
+                      << std::setw( 7 )  << s.active_calls
+                      << std::setw( 7 )  << s.active_requests
+                      << std::setw( 9 )  << s.pending_requests
+                      << std::setw( 10 ) << s.waiting_retries
+                      << std::setw( 14 ) << rate( s.num_dispatched, prev.num_dispatched )
+                      << std::setw( 15 ) << rate( s.num_established, prev.num_established )
+                      << std::setw( 10 ) << rate( s.num_failed, prev.num_failed )
+                      << std::setw( 11 ) << rate( s.num_retries, prev.num_retries )
+                      << std::setw( 13 ) << rate( s.num_retries_exhausted, prev.num_retries_exhausted )
+                      << std::setw( 16 ) << ( retries ? delay / double( retries ) : 0.0 )
+                      << std::endl;
+
+            prev        = s;
+            prev_time   = now;
+            has_prev    = true;
+        }
+
+        if( interval_ms == 0 )
+            break;
+
+        std::this_thread::sleep_for( std::chrono::milliseconds( interval_ms ) );
+    }
+
+    calman::close_stats_page( page );
+
+    return 0;
+}